@@ -2632,6 +2632,39 @@ char *ppp_dev_name(struct ppp_channel *chan)
 	return name;
 }
 
+/*
+ * Return the link a PPP device sends its frames over, for code that
+ * wants to bypass the device in the forwarding path. This only works
+ * for units with a single channel that can describe its link. The
+ * device in the path is only valid under rcu_read_lock().
+ */
+int ppp_dev_fill_path(const struct net_device *dev,
+		      struct ppp_channel_path *path)
+{
+	struct ppp_channel *chan;
+	struct channel *pch;
+	struct ppp *ppp;
+	int err = -EOPNOTSUPP;
+
+	if (dev->netdev_ops != &ppp_netdev_ops)
+		return -EOPNOTSUPP;
+
+	ppp = netdev_priv(dev);
+	ppp_xmit_lock(ppp);
+	if (ppp->n_channels != 1 || (ppp->flags & SC_MULTILINK))
+		goto out;
+
+	pch = list_first_entry(&ppp->channels, struct channel, clist);
+	spin_lock(&pch->downl);
+	chan = pch->chan;
+	if (chan && chan->ops->fill_path)
+		err = chan->ops->fill_path(chan, path);
+	spin_unlock(&pch->downl);
+out:
+	ppp_xmit_unlock(ppp);
+	return err;
+}
+
 
 /*
  * Disconnect a channel from the generic layer.
@@ -3278,6 +3311,7 @@ EXPORT_SYMBOL(ppp_unregister_channel);
 EXPORT_SYMBOL(ppp_channel_index);
 EXPORT_SYMBOL(ppp_unit_number);
 EXPORT_SYMBOL(ppp_dev_name);
+EXPORT_SYMBOL(ppp_dev_fill_path);
 EXPORT_SYMBOL(ppp_input);
 EXPORT_SYMBOL(ppp_input_error);
 EXPORT_SYMBOL(ppp_output_wakeup);
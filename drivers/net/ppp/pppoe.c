@@ -972,8 +972,29 @@ static int pppoe_xmit(struct ppp_channel *chan, struct sk_buff *skb)
 	return __pppoe_xmit(sk, skb);
 }
 
+/* Tell the flowtable fast path where the session's frames go. */
+static int pppoe_fill_path(struct ppp_channel *chan,
+			   struct ppp_channel_path *path)
+{
+	struct sock *sk = (struct sock *)chan->private;
+	struct pppox_sock *po = pppox_sk(sk);
+	struct net_device *dev = po->pppoe_dev;
+
+	if (sock_flag(sk, SOCK_DEAD) || !(sk->sk_state & PPPOX_CONNECTED) ||
+	    !dev)
+		return -ENODEV;
+
+	path->dev = dev;
+	path->proto = htons(ETH_P_PPP_SES);
+	path->id = po->num;
+	memcpy(path->h_dest, po->pppoe_pa.remote, ETH_ALEN);
+
+	return 0;
+}
+
 static const struct ppp_channel_ops pppoe_chan_ops = {
 	.start_xmit = pppoe_xmit,
+	.fill_path = pppoe_fill_path,
 };
 
 static int pppoe_recvmsg(struct socket *sock, struct msghdr *m,
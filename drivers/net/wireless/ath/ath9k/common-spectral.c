@@ -16,6 +16,7 @@
 
 #include <linux/relay.h>
 #include <linux/random.h>
+#include <asm/unaligned.h>
 #include "ath9k.h"
 
 static s8 fix_rssi_inv_only(u8 rssi_val)
@@ -35,6 +36,40 @@ static void ath_debug_send_fft_sample(struct ath_spec_scan_priv *spec_priv,
 	length = __be16_to_cpu(fft_sample_tlv->length) +
 		 sizeof(*fft_sample_tlv);
 	relay_write(spec_priv->rfs_chan_spec_scan, fft_sample_tlv, length);
+	spec_priv->stats.samples++;
+}
+
+/* Returns the index of the first bin above max, or -1 if there is none.
+ * As long as max leaves room for the carry based byte compare, the bins
+ * are checked a word at a time and only the word holding a hit is
+ * scanned byte by byte.
+ */
+static int
+ath_cmn_find_bin_above(u8 *bins, int num_bins, u16 max)
+{
+	const unsigned long ones = ~0UL / 255;
+	int i = 0;
+
+	if (max >= 255)
+		return -1;
+
+	if (max < 128) {
+		for (; i + (int) sizeof(unsigned long) <= num_bins;
+		     i += sizeof(unsigned long)) {
+			unsigned long x;
+
+			x = get_unaligned((unsigned long *) &bins[i]);
+			if (((x + ones * (127 - max)) | x) & (ones * 128))
+				break;
+		}
+	}
+
+	for (; i < num_bins; i++) {
+		if (bins[i] > max)
+			return i;
+	}
+
+	return -1;
 }
 
 typedef int (ath_cmn_fft_idx_validator) (u8 *sample_end, int bytes_read);
@@ -218,14 +253,11 @@ ath_cmn_process_ht20_fft(struct ath_rx_status *rs,
 		ath_dbg(common, SPECTRAL_SCAN,
 			"Calculated new lower max 0x%X at %i\n",
 			tmp_mag, fft_sample_20.max_index);
-	} else
-	for (i = 0; i < SPECTRAL_HT20_NUM_BINS; i++) {
-		if (fft_sample_20.data[i] == (magnitude >> max_exp))
-			ath_dbg(common, SPECTRAL_SCAN,
-				"Got max: 0x%X at index %i\n",
-				fft_sample_20.data[i], i);
-
-		if (fft_sample_20.data[i] > (magnitude >> max_exp)) {
+	} else {
+		i = ath_cmn_find_bin_above(fft_sample_20.data,
+					   SPECTRAL_HT20_NUM_BINS,
+					   magnitude >> max_exp);
+		if (i >= 0) {
 			ath_dbg(common, SPECTRAL_SCAN,
 				"Got bin %i greater than max: 0x%X\n",
 				i, fft_sample_20.data[i]);
@@ -233,8 +265,10 @@ ath_cmn_process_ht20_fft(struct ath_rx_status *rs,
 		}
 	}
 
-	if (ret < 0)
+	if (ret < 0) {
+		spec_priv->stats.invalid++;
 		return ret;
+	}
 
 	tlv = (struct fft_sample_tlv *)&fft_sample_20;
 
@@ -383,14 +417,10 @@ ath_cmn_process_ht20_40_fft(struct ath_rx_status *rs,
 		ath_dbg(common, SPECTRAL_SCAN,
 			"Calculated new lower max 0x%X at %i\n",
 			tmp_mag, fft_sample_40.lower_max_index);
-	} else
-	for (i = 0; i < dc_pos; i++) {
-		if (fft_sample_40.data[i] == (lower_mag >> max_exp))
-			ath_dbg(common, SPECTRAL_SCAN,
-				"Got lower mag: 0x%X at index %i\n",
-				fft_sample_40.data[i], i);
-
-		if (fft_sample_40.data[i] > (lower_mag >> max_exp)) {
+	} else {
+		i = ath_cmn_find_bin_above(fft_sample_40.data, dc_pos,
+					   lower_mag >> max_exp);
+		if (i >= 0) {
 			ath_dbg(common, SPECTRAL_SCAN,
 				"Got lower bin %i higher than max: 0x%X\n",
 				i, fft_sample_40.data[i]);
@@ -412,24 +442,23 @@ ath_cmn_process_ht20_40_fft(struct ath_rx_status *rs,
 		ath_dbg(common, SPECTRAL_SCAN,
 			"Calculated new upper max 0x%X at %i\n",
 			tmp_mag, i);
-	} else
-	for (i = dc_pos; i < SPECTRAL_HT20_40_NUM_BINS; i++) {
-		if (fft_sample_40.data[i] == (upper_mag >> max_exp))
-			ath_dbg(common, SPECTRAL_SCAN,
-				"Got upper mag: 0x%X at index %i\n",
-				fft_sample_40.data[i], i);
-
-		if (fft_sample_40.data[i] > (upper_mag >> max_exp)) {
+	} else {
+		i = ath_cmn_find_bin_above(&fft_sample_40.data[dc_pos],
+					   SPECTRAL_HT20_40_NUM_BINS - dc_pos,
+					   upper_mag >> max_exp);
+		if (i >= 0) {
+			i += dc_pos;
 			ath_dbg(common, SPECTRAL_SCAN,
 				"Got upper bin %i higher than max: 0x%X\n",
 				i, fft_sample_40.data[i]);
-
 			ret = -1;
 		}
 	}
 
-	if (ret < 0)
+	if (ret < 0) {
+		spec_priv->stats.invalid++;
 		return ret;
+	}
 
 	tlv = (struct fft_sample_tlv *)&fft_sample_40;
 
@@ -474,24 +503,22 @@ ath_cmn_copy_fft_frame(u8 *in, u8 *out, int sample_len, int sample_bytes)
 	}
 }
 
+/* Only the buffer relay_write() is going to use matters, which is the
+ * one of the local CPU (or the single global one).
+ */
 static int
 ath_cmn_is_fft_buf_full(struct ath_spec_scan_priv *spec_priv)
 {
-	int i = 0;
-	int ret = 0;
-	struct rchan_buf *buf;
 	struct rchan *rc = spec_priv->rfs_chan_spec_scan;
+	struct rchan_buf *buf;
+	int ret = 0;
 
-	for_each_possible_cpu(i) {
-		if ((buf = *per_cpu_ptr(rc->buf, i))) {
-			ret += relay_buf_full(buf);
-		}
-	}
+	buf = *get_cpu_ptr(rc->buf);
+	if (buf)
+		ret = relay_buf_full(buf);
+	put_cpu_ptr(rc->buf);
 
-	if (ret)
-		return 1;
-	else
-		return 0;
+	return ret ? 1 : 0;
 }
 
 /* returns 1 if this was a spectral frame, even if not handled. */
@@ -536,8 +563,11 @@ int ath_cmn_process_fft(struct ath_spec_scan_priv *spec_priv, struct ieee80211_h
 	/* Output buffers are full, no need to process anything
 	 * since there is no space to put the result anyway
 	 */
+	spec_priv->stats.reports++;
+
 	ret = ath_cmn_is_fft_buf_full(spec_priv);
 	if (ret == 1) {
+		spec_priv->stats.reports_dropped++;
 		ath_dbg(common, SPECTRAL_SCAN, "FFT report ignored, no space "
 						"left on output buffers\n");
 		return 1;
@@ -1044,6 +1074,49 @@ static const struct file_operations fops_spectral_fft_period = {
 	.llseek = default_llseek,
 };
 
+/******************/
+/* spectral_stats */
+/******************/
+
+static ssize_t read_file_spectral_stats(struct file *file,
+					char __user *user_buf,
+					size_t count, loff_t *ppos)
+{
+	struct ath_spec_scan_priv *spec_priv = file->private_data;
+	struct ath_spec_scan_stats *stats = &spec_priv->stats;
+	char buf[256];
+	unsigned int len = 0;
+
+	len += scnprintf(buf + len, sizeof(buf) - len, "%20s : %10u\n",
+			 "reports", stats->reports);
+	len += scnprintf(buf + len, sizeof(buf) - len, "%20s : %10u\n",
+			 "reports dropped", stats->reports_dropped);
+	len += scnprintf(buf + len, sizeof(buf) - len, "%20s : %10u\n",
+			 "samples", stats->samples);
+	len += scnprintf(buf + len, sizeof(buf) - len, "%20s : %10u\n",
+			 "invalid samples", stats->invalid);
+
+	return simple_read_from_buffer(user_buf, count, ppos, buf, len);
+}
+
+static ssize_t write_file_spectral_stats(struct file *file,
+					 const char __user *user_buf,
+					 size_t count, loff_t *ppos)
+{
+	struct ath_spec_scan_priv *spec_priv = file->private_data;
+
+	memset(&spec_priv->stats, 0, sizeof(spec_priv->stats));
+	return count;
+}
+
+static const struct file_operations fops_spectral_stats = {
+	.read = read_file_spectral_stats,
+	.write = write_file_spectral_stats,
+	.open = simple_open,
+	.owner = THIS_MODULE,
+	.llseek = default_llseek,
+};
+
 /*******************/
 /* Relay interface */
 /*******************/
@@ -1117,5 +1190,9 @@ void ath9k_cmn_spectral_init_debug(struct ath_spec_scan_priv *spec_priv,
 			    0600,
 			    debugfs_phy, spec_priv,
 			    &fops_spectral_fft_period);
+	debugfs_create_file("spectral_stats",
+			    0600,
+			    debugfs_phy, spec_priv,
+			    &fops_spectral_stats);
 }
 EXPORT_SYMBOL(ath9k_cmn_spectral_init_debug);
@@ -94,12 +94,28 @@ struct ath_ht20_40_fft_packet {
 	struct ath_radar_info radar_info;
 } __packed;
 
+/**
+ * struct ath_spec_scan_stats - spectral scan sample statistics
+ *
+ * @reports: spectral reports received from the hardware
+ * @reports_dropped: reports discarded because the relay buffer was full
+ * @samples: FFT samples passed to the relay buffer
+ * @invalid: FFT samples discarded by the magnitude consistency checks
+ */
+struct ath_spec_scan_stats {
+	u32 reports;
+	u32 reports_dropped;
+	u32 samples;
+	u32 invalid;
+};
+
 struct ath_spec_scan_priv {
 	struct ath_hw *ah;
 	/* relay(fs) channel for spectral scan */
 	struct rchan *rfs_chan_spec_scan;
 	enum spectral_mode spectral_mode;
 	struct ath_spec_scan spec_config;
+	struct ath_spec_scan_stats stats;
 };
 
 #define SPECTRAL_HT20_40_TOTAL_DATA_LEN	(sizeof(struct ath_ht20_40_fft_packet))
@@ -295,6 +295,31 @@ static const struct file_operations fops_airtime = {
 };
 
 
+#ifdef CONFIG_ATH9K_DYNACK
+static ssize_t read_file_node_ackto(struct file *file, char __user *user_buf,
+				    size_t count, loff_t *ppos)
+{
+	struct ath_node *an = file->private_data;
+	struct ath_dynack *da = &an->sc->sc_ah->dynack;
+	char buf[64];
+	unsigned int len;
+
+	spin_lock_bh(&da->qlock);
+	len = scnprintf(buf, sizeof(buf), "%u %u\n", an->dyn.ackto,
+			an->dyn.nsamples);
+	spin_unlock_bh(&da->qlock);
+
+	return simple_read_from_buffer(user_buf, count, ppos, buf, len);
+}
+
+static const struct file_operations fops_node_ackto = {
+	.read = read_file_node_ackto,
+	.open = simple_open,
+	.owner = THIS_MODULE,
+	.llseek = default_llseek,
+};
+#endif
+
 void ath9k_sta_add_debugfs(struct ieee80211_hw *hw,
 			   struct ieee80211_vif *vif,
 			   struct ieee80211_sta *sta,
@@ -305,4 +330,7 @@ void ath9k_sta_add_debugfs(struct ieee80211_hw *hw,
 	debugfs_create_file("node_aggr", 0444, dir, an, &fops_node_aggr);
 	debugfs_create_file("node_recv", 0444, dir, an, &fops_node_recv);
 	debugfs_create_file("airtime", 0444, dir, an, &fops_airtime);
+#ifdef CONFIG_ATH9K_DYNACK
+	debugfs_create_file("ack_to", 0444, dir, an, &fops_node_ackto);
+#endif
 }
@@ -58,8 +58,6 @@ struct ath_dfs_stats {
 #define DFS_STAT_INC(sc, c) (sc->debug.stats.dfs_stats.c++)
 void ath9k_dfs_init_debug(struct ath_softc *sc);
 
-extern struct ath_dfs_pool_stats global_dfs_pool_stats;
-
 #else
 
 #define DFS_STAT_INC(sc, c) do { } while (0)
@@ -34,6 +34,55 @@ static inline u32 ath_dynack_ewma(u32 old, u32 new)
 	return (new * (EWMA_DIV - EWMA_LEVEL) + old * EWMA_LEVEL) / EWMA_DIV;
 }
 
+/**
+ * ath_dynack_median - median of the station sample window
+ * @ds: station estimator
+ *
+ */
+static u32 ath_dynack_median(struct ath_dyn_sta *ds)
+{
+	u16 sorted[ATH_DYN_STA_BUF];
+	int i, j;
+
+	for (i = 0; i < ds->count; i++) {
+		u16 val = ds->samples[i];
+
+		for (j = i; j > 0 && sorted[j - 1] > val; j--)
+			sorted[j] = sorted[j - 1];
+		sorted[j] = val;
+	}
+
+	return sorted[ds->count / 2];
+}
+
+/**
+ * ath_dynack_sta_update - add an ACK timeout sample to a station estimate
+ * @ds: station estimator
+ * @ackto: ACK timeout sample
+ *
+ * A single sample matched against the wrong ACK must not move the
+ * estimate, so the EWMA is fed with the median of the last samples.
+ * Until the window is filled the median is used as it is, which lets a
+ * new station converge after a handful of frames instead of crawling up
+ * from the default timeout.
+ */
+static void ath_dynack_sta_update(struct ath_dyn_sta *ds, u32 ackto)
+{
+	u32 median;
+
+	ds->samples[ds->idx] = ackto;
+	INCR(ds->idx, ATH_DYN_STA_BUF);
+	if (ds->count < ATH_DYN_STA_BUF)
+		ds->count++;
+	ds->nsamples++;
+
+	median = ath_dynack_median(ds);
+	if (ds->count < ATH_DYN_STA_BUF)
+		ds->ackto = median;
+	else
+		ds->ackto = ath_dynack_ewma(ds->ackto, median);
+}
+
 /**
  * ath_dynack_get_sifs - get sifs time based on phy used
  * @ah: ath hw
@@ -88,8 +137,8 @@ static void ath_dynack_compute_ackto(struct ath_hw *ah)
 	struct ath_common *common = ath9k_hw_common(ah);
 
 	list_for_each_entry(an, &da->nodes, list)
-		if (an->ackto > to)
-			to = an->ackto;
+		if (an->dyn.ackto > to)
+			to = an->dyn.ackto;
 
 	if (to && da->ackto != to) {
 		u32 slottime;
@@ -141,13 +190,20 @@ static void ath_dynack_compute_to(struct ath_hw *ah)
 								   src);
 				if (sta) {
 					an = (struct ath_node *)sta->drv_priv;
-					an->ackto = ath_dynack_ewma(an->ackto,
-								    ackto);
+					ath_dynack_sta_update(&an->dyn, ackto);
 					ath_dbg(ath9k_hw_common(ah), DYNACK,
-						"%pM to %u\n", dst, an->ackto);
-					if (time_is_before_jiffies(da->lto)) {
+						"%pM to %u\n", dst,
+						an->dyn.ackto);
+					/* a timeout shorter than the real
+					 * one costs retries, apply
+					 * increases right away
+					 */
+					if (time_is_before_jiffies(da->lto) ||
+					    (an->dyn.ackto > da->ackto &&
+					     !da->lateack)) {
 						ath_dynack_compute_ackto(ah);
 						da->lto = jiffies + COMPUTE_TO;
+						da->lateack = false;
 					}
 				}
 				INCR(da->ack_rbf.h_rb, ATH_DYN_BUF);
@@ -193,6 +249,7 @@ void ath_dynack_sample_tx_ts(struct ath_hw *ah, struct sk_buff *skb,
 			ath9k_hw_set_ack_timeout(ah, LATEACK_TO);
 			ath9k_hw_set_cts_timeout(ah, LATEACK_TO);
 			da->lto = jiffies + LATEACK_DELAY;
+			da->lateack = true;
 		}
 
 		spin_unlock_bh(&da->qlock);
@@ -283,7 +340,8 @@ void ath_dynack_node_init(struct ath_hw *ah, struct ath_node *an)
 	u32 ackto = 9 + 16 + 64;
 	struct ath_dynack *da = &ah->dynack;
 
-	an->ackto = ackto;
+	memset(&an->dyn, 0, sizeof(an->dyn));
+	an->dyn.ackto = ackto;
 
 	spin_lock(&da->qlock);
 	list_add_tail(&an->list, &da->nodes);
@@ -319,6 +377,7 @@ void ath_dynack_reset(struct ath_hw *ah)
 	struct ath_dynack *da = &ah->dynack;
 
 	da->lto = jiffies;
+	da->lateack = false;
 	da->ackto = ackto;
 
 	da->st_rbf.t_rb = 0;
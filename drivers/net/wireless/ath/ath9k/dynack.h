@@ -18,6 +18,7 @@
 #define DYNACK_H
 
 #define ATH_DYN_BUF	64
+#define ATH_DYN_STA_BUF	8
 
 struct ath_hw;
 struct ath_node;
@@ -56,11 +57,28 @@ struct ath_dyn_txbuf {
 	struct ts_info ts[ATH_DYN_BUF];
 };
 
+/**
+ * struct ath_dyn_sta - per-station ACK timeout estimator
+ * @ackto: current ACK timeout estimate
+ * @samples: most recent ACK timeout samples
+ * @idx: next slot in @samples
+ * @count: number of valid entries in @samples
+ * @nsamples: samples accounted to this station so far
+ */
+struct ath_dyn_sta {
+	u32 ackto;
+	u16 samples[ATH_DYN_STA_BUF];
+	u8 idx;
+	u8 count;
+	u32 nsamples;
+};
+
 /**
  * struct ath_dynack - dynack processing info
  * @enabled: enable dyn ack processing
  * @ackto: current ACK timeout
  * @lto: last ACK timeout computation
+ * @lateack: late ACK timeout is in effect until @lto
  * @nodes: ath_node linked list
  * @qlock: ts queue spinlock
  * @ack_rbf: ACK ts ring buffer
@@ -70,6 +88,7 @@ struct ath_dynack {
 	bool enabled;
 	int ackto;
 	unsigned long lto;
+	bool lateack;
 
 	struct list_head nodes;
 
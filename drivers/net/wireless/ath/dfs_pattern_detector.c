@@ -210,7 +210,9 @@ channel_detector_create(struct dfs_pattern_detector *dpd, u16 freq)
 
 	for (i = 0; i < dpd->num_radar_types; i++) {
 		const struct radar_detector_specs *rs = &dpd->radar_spec[i];
-		struct pri_detector *de = pri_detector_init(rs);
+		struct pri_detector *de;
+
+		de = pri_detector_init(rs, &dpd->pool_stats);
 		if (de == NULL)
 			goto fail;
 		cd->detectors[i] = de;
@@ -312,7 +314,7 @@ dpd_add_pulse(struct dfs_pattern_detector *dpd, struct pulse_event *event,
 static struct ath_dfs_pool_stats
 dpd_get_stats(struct dfs_pattern_detector *dpd)
 {
-	return global_dfs_pool_stats;
+	return dpd->pool_stats;
 }
 
 static bool dpd_set_domain(struct dfs_pattern_detector *dpd,
@@ -27,7 +27,7 @@
 #define PRI_TOLERANCE	16
 
 /**
- * struct ath_dfs_pool_stats - DFS Statistics for global pools
+ * struct ath_dfs_pool_stats - DFS Statistics for detector pools
  */
 struct ath_dfs_pool_stats {
 	u32 pool_reference;
@@ -91,6 +91,7 @@ struct radar_detector_specs {
  * @last_pulse_ts: time stamp of last valid pulse in usecs
  * @radar_detector_specs: array of radar detection specs
  * @channel_detectors: list connecting channel_detector elements
+ * @pool_stats: statistics of the pulse and sequence pools of all detectors
  */
 struct dfs_pattern_detector {
 	void (*exit)(struct dfs_pattern_detector *dpd);
@@ -109,6 +110,7 @@ struct dfs_pattern_detector {
 
 	const struct radar_detector_specs *radar_spec;
 	struct list_head channel_detectors;
+	struct ath_dfs_pool_stats pool_stats;
 };
 
 /**
@@ -15,29 +15,19 @@
  */
 
 #include <linux/slab.h>
-#include <linux/spinlock.h>
 
 #include "ath.h"
 #include "dfs_pattern_detector.h"
 #include "dfs_pri_detector.h"
 
-struct ath_dfs_pool_stats global_dfs_pool_stats = {};
-
-#define DFS_POOL_STAT_INC(c) (global_dfs_pool_stats.c++)
-#define DFS_POOL_STAT_DEC(c) (global_dfs_pool_stats.c--)
+#define DFS_POOL_STAT_INC(pde, c) ((pde)->stats->c++)
+#define DFS_POOL_STAT_DEC(pde, c) ((pde)->stats->c--)
+#define DFS_POOL_STAT_ADD(pde, c, n) ((pde)->stats->c += (n))
+#define DFS_POOL_STAT_SUB(pde, c, n) ((pde)->stats->c -= (n))
 #define GET_PRI_TO_USE(MIN, MAX, RUNTIME) \
 	(MIN + PRI_TOLERANCE == MAX - PRI_TOLERANCE ? \
 	MIN + PRI_TOLERANCE : RUNTIME)
 
-/**
- * struct pulse_elem - elements in pulse queue
- * @ts: time stamp in usecs
- */
-struct pulse_elem {
-	struct list_head head;
-	u64 ts;
-};
-
 /**
  * pde_get_multiple() - get number of multiples considering a given tolerance
  * @return factor if abs(val - factor*fraction) <= tolerance, 0 otherwise
@@ -71,109 +61,101 @@ static u32 pde_get_multiple(u32 val, u32 fraction, u32 tolerance)
 }
 
 /**
- * DOC: Singleton Pulse and Sequence Pools
+ * DOC: Per-Detector Pulse and Sequence Pools
  *
- * Instances of pri_sequence and pulse_elem are kept in singleton pools to
- * reduce the number of dynamic allocations. They are shared between all
- * instances and grow up to the peak number of simultaneously used objects.
+ * Every pri_detector owns its pulse queue and sequence pool, so detectors of
+ * different radios or channels never contend for a shared lock. The pulse
+ * queue is a ring of max_count time stamps allocated up front, the newest
+ * pulse lives at pulses_head and older ones follow backwards.
  *
- * Memory is freed after all references to the pools are released.
+ * Sequences are taken from a free list that is preallocated with max_count
+ * elements and grows up to the peak number of simultaneously used objects.
+ * All memory is freed when the detector is destroyed.
  */
-static u32 singleton_pool_references;
-static LIST_HEAD(pulse_pool);
-static LIST_HEAD(pseq_pool);
-static DEFINE_SPINLOCK(pool_lock);
-
-static void pool_register_ref(void)
+static u32 pulse_queue_prev(struct pri_detector *pde, u32 idx)
 {
-	spin_lock_bh(&pool_lock);
-	singleton_pool_references++;
-	DFS_POOL_STAT_INC(pool_reference);
-	spin_unlock_bh(&pool_lock);
+	return idx ? idx - 1 : pde->max_count - 1;
 }
 
-static void pool_deregister_ref(void)
+static u32 pulse_queue_tail(struct pri_detector *pde)
 {
-	spin_lock_bh(&pool_lock);
-	singleton_pool_references--;
-	DFS_POOL_STAT_DEC(pool_reference);
-	if (singleton_pool_references == 0) {
-		/* free singleton pools with no references left */
-		struct pri_sequence *ps, *ps0;
-		struct pulse_elem *p, *p0;
-
-		list_for_each_entry_safe(p, p0, &pulse_pool, head) {
-			list_del(&p->head);
-			DFS_POOL_STAT_DEC(pulse_allocated);
-			kfree(p);
-		}
-		list_for_each_entry_safe(ps, ps0, &pseq_pool, head) {
-			list_del(&ps->head);
-			DFS_POOL_STAT_DEC(pseq_allocated);
-			kfree(ps);
-		}
-	}
-	spin_unlock_bh(&pool_lock);
-}
+	u32 idx = pde->pulses_head + pde->max_count - (pde->count - 1);
 
-static void pool_put_pulse_elem(struct pulse_elem *pe)
-{
-	spin_lock_bh(&pool_lock);
-	list_add(&pe->head, &pulse_pool);
-	DFS_POOL_STAT_DEC(pulse_used);
-	spin_unlock_bh(&pool_lock);
+	return idx >= pde->max_count ? idx - pde->max_count : idx;
 }
 
-static void pool_put_pseq_elem(struct pri_sequence *pse)
+static void pool_put_pseq_elem(struct pri_detector *pde,
+			       struct pri_sequence *pse)
 {
-	spin_lock_bh(&pool_lock);
-	list_add(&pse->head, &pseq_pool);
-	DFS_POOL_STAT_DEC(pseq_used);
-	spin_unlock_bh(&pool_lock);
+	list_add(&pse->head, &pde->pseq_pool);
+	DFS_POOL_STAT_DEC(pde, pseq_used);
 }
 
-static struct pri_sequence *pool_get_pseq_elem(void)
+static struct pri_sequence *pool_get_pseq_elem(struct pri_detector *pde)
 {
-	struct pri_sequence *pse = NULL;
-	spin_lock_bh(&pool_lock);
-	if (!list_empty(&pseq_pool)) {
-		pse = list_first_entry(&pseq_pool, struct pri_sequence, head);
+	struct pri_sequence *pse;
+
+	if (list_empty(&pde->pseq_pool)) {
+		pse = kmalloc(sizeof(*pse), GFP_ATOMIC);
+		if (pse == NULL) {
+			DFS_POOL_STAT_INC(pde, pseq_alloc_error);
+			return NULL;
+		}
+		DFS_POOL_STAT_INC(pde, pseq_allocated);
+	} else {
+		pse = list_first_entry(&pde->pseq_pool, struct pri_sequence,
+				       head);
 		list_del(&pse->head);
-		DFS_POOL_STAT_INC(pseq_used);
 	}
-	spin_unlock_bh(&pool_lock);
+	DFS_POOL_STAT_INC(pde, pseq_used);
 	return pse;
 }
 
-static struct pulse_elem *pool_get_pulse_elem(void)
+static void pool_free(struct pri_detector *pde)
 {
-	struct pulse_elem *pe = NULL;
-	spin_lock_bh(&pool_lock);
-	if (!list_empty(&pulse_pool)) {
-		pe = list_first_entry(&pulse_pool, struct pulse_elem, head);
-		list_del(&pe->head);
-		DFS_POOL_STAT_INC(pulse_used);
+	struct pri_sequence *ps, *ps0;
+
+	list_for_each_entry_safe(ps, ps0, &pde->pseq_pool, head) {
+		list_del(&ps->head);
+		DFS_POOL_STAT_DEC(pde, pseq_allocated);
+		kfree(ps);
+	}
+	if (pde->pulses) {
+		DFS_POOL_STAT_SUB(pde, pulse_allocated, pde->max_count);
+		kfree(pde->pulses);
 	}
-	spin_unlock_bh(&pool_lock);
-	return pe;
 }
 
-static struct pulse_elem *pulse_queue_get_tail(struct pri_detector *pde)
+static bool pool_init(struct pri_detector *pde)
 {
-	struct list_head *l = &pde->pulses;
-	if (list_empty(l))
-		return NULL;
-	return list_entry(l->prev, struct pulse_elem, head);
+	struct pri_sequence *ps;
+	u32 i;
+
+	pde->pulses = kcalloc(pde->max_count, sizeof(*pde->pulses),
+			      GFP_ATOMIC);
+	if (pde->pulses == NULL) {
+		DFS_POOL_STAT_INC(pde, pulse_alloc_error);
+		return false;
+	}
+	DFS_POOL_STAT_ADD(pde, pulse_allocated, pde->max_count);
+
+	for (i = 0; i < pde->max_count; i++) {
+		ps = kmalloc(sizeof(*ps), GFP_ATOMIC);
+		if (ps == NULL) {
+			DFS_POOL_STAT_INC(pde, pseq_alloc_error);
+			return false;
+		}
+		list_add(&ps->head, &pde->pseq_pool);
+		DFS_POOL_STAT_INC(pde, pseq_allocated);
+	}
+	return true;
 }
 
 static bool pulse_queue_dequeue(struct pri_detector *pde)
 {
-	struct pulse_elem *p = pulse_queue_get_tail(pde);
-	if (p != NULL) {
-		list_del_init(&p->head);
+	if (pde->count > 0) {
 		pde->count--;
-		/* give it back to pool */
-		pool_put_pulse_elem(p);
+		DFS_POOL_STAT_DEC(pde, pulse_used);
 	}
 	return (pde->count > 0);
 }
@@ -182,7 +164,6 @@ static bool pulse_queue_dequeue(struct pri_detector *pde)
 static void pulse_queue_check_window(struct pri_detector *pde)
 {
 	u64 min_valid_ts;
-	struct pulse_elem *p;
 
 	/* there is no delta time with less than 2 pulses */
 	if (pde->count < 2)
@@ -192,8 +173,8 @@ static void pulse_queue_check_window(struct pri_detector *pde)
 		return;
 
 	min_valid_ts = pde->last_ts - pde->window_size;
-	while ((p = pulse_queue_get_tail(pde)) != NULL) {
-		if (p->ts >= min_valid_ts)
+	while (pde->count > 0) {
+		if (pde->pulses[pulse_queue_tail(pde)] >= min_valid_ts)
 			return;
 		pulse_queue_dequeue(pde);
 	}
@@ -201,20 +182,12 @@ static void pulse_queue_check_window(struct pri_detector *pde)
 
 static bool pulse_queue_enqueue(struct pri_detector *pde, u64 ts)
 {
-	struct pulse_elem *p = pool_get_pulse_elem();
-	if (p == NULL) {
-		p = kmalloc(sizeof(*p), GFP_ATOMIC);
-		if (p == NULL) {
-			DFS_POOL_STAT_INC(pulse_alloc_error);
-			return false;
-		}
-		DFS_POOL_STAT_INC(pulse_allocated);
-		DFS_POOL_STAT_INC(pulse_used);
-	}
-	INIT_LIST_HEAD(&p->head);
-	p->ts = ts;
-	list_add(&p->head, &pde->pulses);
+	pde->pulses_head++;
+	if (pde->pulses_head == pde->max_count)
+		pde->pulses_head = 0;
+	pde->pulses[pde->pulses_head] = ts;
 	pde->count++;
+	DFS_POOL_STAT_INC(pde, pulse_used);
 	pde->last_ts = ts;
 	pulse_queue_check_window(pde);
 	if (pde->count >= pde->max_count)
@@ -222,16 +195,27 @@ static bool pulse_queue_enqueue(struct pri_detector *pde, u64 ts)
 	return true;
 }
 
+/*
+ * Pulses are walked from newest to oldest, each one spanning a candidate
+ * PRI with the new pulse. A sequence is only kept if it ends up with more
+ * than min_count pulses, so candidates are skipped as soon as the pulses
+ * left in the queue cannot get them there anymore. Sequences already
+ * tracking a PRI have been extended with ts before, which raises min_count
+ * and prunes the re-scan of those PRIs early.
+ */
 static bool pseq_handler_create_sequences(struct pri_detector *pde,
 					  u64 ts, u32 min_count)
 {
-	struct pulse_elem *p;
-	list_for_each_entry(p, &pde->pulses, head) {
+	u32 i, idx;
+
+	idx = pde->pulses_head;
+	for (i = 0; i < pde->count; i++, idx = pulse_queue_prev(pde, idx)) {
 		struct pri_sequence ps, *new_ps;
-		struct pulse_elem *p2;
 		u32 tmp_false_count;
 		u64 min_valid_ts;
-		u32 delta_ts = ts - p->ts;
+		u64 p_ts = pde->pulses[idx];
+		u32 delta_ts = ts - p_ts;
+		u32 j, idx2;
 
 		if (delta_ts < pde->rs->pri_min)
 			/* ignore too small pri */
@@ -241,31 +225,41 @@ static bool pseq_handler_create_sequences(struct pri_detector *pde,
 			/* stop on too large pri (sorted list) */
 			break;
 
+		/* new pulse, this one and all older ones would not suffice */
+		if (2 + (pde->count - i - 1) <= min_count)
+			break;
+
 		/* build a new sequence with new potential pri */
 		ps.count = 2;
 		ps.count_falses = 0;
-		ps.first_ts = p->ts;
+		ps.first_ts = p_ts;
 		ps.last_ts = ts;
 		ps.pri = GET_PRI_TO_USE(pde->rs->pri_min,
-			pde->rs->pri_max, ts - p->ts);
+			pde->rs->pri_max, ts - p_ts);
 		ps.dur = ps.pri * (pde->rs->ppb - 1)
 				+ 2 * pde->rs->max_pri_tolerance;
 
-		p2 = p;
 		tmp_false_count = 0;
 		min_valid_ts = ts - ps.dur;
 		/* check which past pulses are candidates for new sequence */
-		list_for_each_entry_continue(p2, &pde->pulses, head) {
+		idx2 = pulse_queue_prev(pde, idx);
+		for (j = i + 1; j < pde->count;
+		     j++, idx2 = pulse_queue_prev(pde, idx2)) {
+			u64 p2_ts = pde->pulses[idx2];
 			u32 factor;
-			if (p2->ts < min_valid_ts)
+
+			if (p2_ts < min_valid_ts)
 				/* stop on crossing window border */
 				break;
+			if (ps.count + (pde->count - j) <= min_count)
+				/* cannot reach minimum count anymore */
+				break;
 			/* check if pulse match (multi)PRI */
-			factor = pde_get_multiple(ps.last_ts - p2->ts, ps.pri,
+			factor = pde_get_multiple(ps.last_ts - p2_ts, ps.pri,
 						  pde->rs->max_pri_tolerance);
 			if (factor > 0) {
 				ps.count++;
-				ps.first_ts = p2->ts;
+				ps.first_ts = p2_ts;
 				/*
 				 * on match, add the intermediate falses
 				 * and reset counter
@@ -283,16 +277,9 @@ static bool pseq_handler_create_sequences(struct pri_detector *pde,
 
 		/* this is a valid one, add it */
 		ps.deadline_ts = ps.first_ts + ps.dur;
-		new_ps = pool_get_pseq_elem();
-		if (new_ps == NULL) {
-			new_ps = kmalloc(sizeof(*new_ps), GFP_ATOMIC);
-			if (new_ps == NULL) {
-				DFS_POOL_STAT_INC(pseq_alloc_error);
-				return false;
-			}
-			DFS_POOL_STAT_INC(pseq_allocated);
-			DFS_POOL_STAT_INC(pseq_used);
-		}
+		new_ps = pool_get_pseq_elem(pde);
+		if (new_ps == NULL)
+			return false;
 		memcpy(new_ps, &ps, sizeof(ps));
 		INIT_LIST_HEAD(&new_ps->head);
 		list_add(&new_ps->head, &pde->sequences);
@@ -313,7 +300,7 @@ pseq_handler_add_to_existing_seqs(struct pri_detector *pde, u64 ts)
 		/* first ensure that sequence is within window */
 		if (ts > ps->deadline_ts) {
 			list_del_init(&ps->head);
-			pool_put_pseq_elem(ps);
+			pool_put_pseq_elem(pde, ps);
 			continue;
 		}
 
@@ -359,15 +346,11 @@ pseq_handler_check_detection(struct pri_detector *pde)
 static void pri_detector_reset(struct pri_detector *pde, u64 ts)
 {
 	struct pri_sequence *ps, *ps0;
-	struct pulse_elem *p, *p0;
 	list_for_each_entry_safe(ps, ps0, &pde->sequences, head) {
 		list_del_init(&ps->head);
-		pool_put_pseq_elem(ps);
-	}
-	list_for_each_entry_safe(p, p0, &pde->pulses, head) {
-		list_del_init(&p->head);
-		pool_put_pulse_elem(p);
+		pool_put_pseq_elem(pde, ps);
 	}
+	DFS_POOL_STAT_SUB(pde, pulse_used, pde->count);
 	pde->count = 0;
 	pde->last_ts = ts;
 }
@@ -375,7 +358,8 @@ static void pri_detector_reset(struct pri_detector *pde, u64 ts)
 static void pri_detector_exit(struct pri_detector *de)
 {
 	pri_detector_reset(de, 0);
-	pool_deregister_ref();
+	pool_free(de);
+	DFS_POOL_STAT_DEC(de, pool_reference);
 	kfree(de);
 }
 
@@ -415,7 +399,8 @@ static struct pri_sequence *pri_detector_add_pulse(struct pri_detector *de,
 	return ps;
 }
 
-struct pri_detector *pri_detector_init(const struct radar_detector_specs *rs)
+struct pri_detector *pri_detector_init(const struct radar_detector_specs *rs,
+				       struct ath_dfs_pool_stats *stats)
 {
 	struct pri_detector *de;
 
@@ -427,11 +412,16 @@ struct pri_detector *pri_detector_init(const struct radar_detector_specs *rs)
 	de->reset = pri_detector_reset;
 
 	INIT_LIST_HEAD(&de->sequences);
-	INIT_LIST_HEAD(&de->pulses);
+	INIT_LIST_HEAD(&de->pseq_pool);
 	de->window_size = rs->pri_max * rs->ppb * rs->num_pri;
 	de->max_count = rs->ppb * 2;
 	de->rs = rs;
+	de->stats = stats;
 
-	pool_register_ref();
+	DFS_POOL_STAT_INC(de, pool_reference);
+	if (!pool_init(de)) {
+		pri_detector_exit(de);
+		return NULL;
+	}
 	return de;
 }
@@ -19,8 +19,6 @@
 
 #include <linux/list.h>
 
-extern struct ath_dfs_pool_stats global_dfs_pool_stats;
-
 /**
  * struct pri_sequence - sequence of pulses matching one PRI
  * @head: list_head
@@ -51,10 +49,13 @@ struct pri_sequence {
  * @rs: detector specs for this detector element
  * @last_ts: last pulse time stamp considered for this element in usecs
  * @sequences: list_head holding potential pulse sequences
- * @pulses: list connecting pulse_elem objects
+ * @pseq_pool: list_head holding unused pri_sequence objects
+ * @pulses: ring of max_count pulse time stamps in usecs
+ * @pulses_head: index of the newest pulse in the ring
  * @count: number of pulses in queue
  * @max_count: maximum number of pulses to be queued
  * @window_size: window size back from newest pulse time stamp in usecs
+ * @stats: pool statistics of the owning pattern detector
  */
 struct pri_detector {
 	void (*exit)     (struct pri_detector *de);
@@ -67,12 +68,16 @@ struct pri_detector {
 /* private: internal use only */
 	u64 last_ts;
 	struct list_head sequences;
-	struct list_head pulses;
+	struct list_head pseq_pool;
+	u64 *pulses;
+	u32 pulses_head;
 	u32 count;
 	u32 max_count;
 	u32 window_size;
+	struct ath_dfs_pool_stats *stats;
 };
 
-struct pri_detector *pri_detector_init(const struct radar_detector_specs *rs);
+struct pri_detector *pri_detector_init(const struct radar_detector_specs *rs,
+				       struct ath_dfs_pool_stats *stats);
 
 #endif /* DFS_PRI_DETECTOR_H */
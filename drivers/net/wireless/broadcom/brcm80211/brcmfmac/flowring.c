@@ -17,6 +17,8 @@
 #include <linux/types.h>
 #include <linux/netdevice.h>
 #include <linux/etherdevice.h>
+#include <linux/jhash.h>
+#include <linux/random.h>
 #include <brcmu_utils.h>
 
 #include "core.h"
@@ -32,8 +34,7 @@
 #define BRCMF_FLOWRING_LOW		(BRCMF_FLOWRING_HIGH - 256)
 #define BRCMF_FLOWRING_INVALID_IFIDX	0xff
 
-#define BRCMF_FLOWRING_HASH_AP(da, fifo, ifidx) (da[5] * 2 + fifo + ifidx * 16)
-#define BRCMF_FLOWRING_HASH_STA(fifo, ifidx) (fifo + ifidx * 16)
+#define BRCMF_FLOWRING_HASH_MASK	(BRCMF_FLOWRING_HASHSIZE - 1)
 
 static const u8 brcmf_flowring_prio2fifo[] = {
 	1,
@@ -66,45 +67,76 @@ brcmf_flowring_is_tdls_mac(struct brcmf_flowring *flow, u8 mac[ETH_ALEN])
 }
 
 
+static u8 *brcmf_flowring_key(struct brcmf_flowring *flow, u8 da[ETH_ALEN],
+			      u8 prio, u8 ifidx, u8 *fifo, bool *sta)
+{
+	u8 *mac;
+
+	*fifo = brcmf_flowring_prio2fifo[prio];
+	*sta = (flow->addr_mode[ifidx] == ADDR_INDIRECT);
+	mac = da;
+	if ((!*sta) && (is_multicast_ether_addr(da))) {
+		mac = (u8 *)ALLFFMAC;
+		*fifo = 0;
+	}
+	if ((*sta) && (flow->tdls_active) &&
+	    (brcmf_flowring_is_tdls_mac(flow, da))) {
+		*sta = false;
+	}
+
+	return mac;
+}
+
+
+static u16 brcmf_flowring_hash_idx(struct brcmf_flowring *flow, u8 *mac,
+				   u8 fifo, u8 ifidx, bool sta)
+{
+	u32 key = fifo | (ifidx << 8);
+
+	/* in indirect (STA) mode all traffic of a fifo shares one ring */
+	if (sta)
+		return jhash_1word(key, flow->hash_seed) &
+		       BRCMF_FLOWRING_HASH_MASK;
+
+	return jhash(mac, ETH_ALEN, flow->hash_seed ^ key) &
+	       BRCMF_FLOWRING_HASH_MASK;
+}
+
+
+static bool brcmf_flowring_hash_empty(struct brcmf_flowring_hash *hash)
+{
+	return hash->ifidx == BRCMF_FLOWRING_INVALID_IFIDX && !hash->deleted;
+}
+
+
+/* Probe chains never get longer than the largest displacement any entry
+ * was inserted with, so a miss stops after max_probe slots or at the first
+ * slot that was never used, whichever comes first. Deleted slots are left
+ * as tombstones so entries further down the chain stay reachable.
+ */
 u32 brcmf_flowring_lookup(struct brcmf_flowring *flow, u8 da[ETH_ALEN],
 			  u8 prio, u8 ifidx)
 {
 	struct brcmf_flowring_hash *hash;
 	u16 hash_idx;
 	u32 i;
-	bool found;
 	bool sta;
 	u8 fifo;
 	u8 *mac;
 
-	fifo = brcmf_flowring_prio2fifo[prio];
-	sta = (flow->addr_mode[ifidx] == ADDR_INDIRECT);
-	mac = da;
-	if ((!sta) && (is_multicast_ether_addr(da))) {
-		mac = (u8 *)ALLFFMAC;
-		fifo = 0;
-	}
-	if ((sta) && (flow->tdls_active) &&
-	    (brcmf_flowring_is_tdls_mac(flow, da))) {
-		sta = false;
-	}
-	hash_idx =  sta ? BRCMF_FLOWRING_HASH_STA(fifo, ifidx) :
-			  BRCMF_FLOWRING_HASH_AP(mac, fifo, ifidx);
-	hash_idx &= (BRCMF_FLOWRING_HASHSIZE - 1);
-	found = false;
+	mac = brcmf_flowring_key(flow, da, prio, ifidx, &fifo, &sta);
+	hash_idx = brcmf_flowring_hash_idx(flow, mac, fifo, ifidx, sta);
 	hash = flow->hash;
-	for (i = 0; i < BRCMF_FLOWRING_HASHSIZE; i++) {
+	for (i = 0; i <= flow->max_probe; i++) {
+		if (brcmf_flowring_hash_empty(&hash[hash_idx]))
+			break;
 		if ((sta || (memcmp(hash[hash_idx].mac, mac, ETH_ALEN) == 0)) &&
 		    (hash[hash_idx].fifo == fifo) &&
-		    (hash[hash_idx].ifidx == ifidx)) {
-			found = true;
-			break;
-		}
+		    (hash[hash_idx].ifidx == ifidx))
+			return hash[hash_idx].flowid;
 		hash_idx++;
-		hash_idx &= (BRCMF_FLOWRING_HASHSIZE - 1);
+		hash_idx &= BRCMF_FLOWRING_HASH_MASK;
 	}
-	if (found)
-		return hash[hash_idx].flowid;
 
 	return BRCMF_FLOWRING_INVALID_ID;
 }
@@ -116,62 +148,91 @@ u32 brcmf_flowring_create(struct brcmf_flowring *flow, u8 da[ETH_ALEN],
 	struct brcmf_flowring_ring *ring;
 	struct brcmf_flowring_hash *hash;
 	u16 hash_idx;
+	u32 probe;
 	u32 i;
-	bool found;
 	u8 fifo;
 	bool sta;
 	u8 *mac;
 
-	fifo = brcmf_flowring_prio2fifo[prio];
-	sta = (flow->addr_mode[ifidx] == ADDR_INDIRECT);
-	mac = da;
-	if ((!sta) && (is_multicast_ether_addr(da))) {
-		mac = (u8 *)ALLFFMAC;
-		fifo = 0;
-	}
-	if ((sta) && (flow->tdls_active) &&
-	    (brcmf_flowring_is_tdls_mac(flow, da))) {
-		sta = false;
-	}
-	hash_idx =  sta ? BRCMF_FLOWRING_HASH_STA(fifo, ifidx) :
-			  BRCMF_FLOWRING_HASH_AP(mac, fifo, ifidx);
-	hash_idx &= (BRCMF_FLOWRING_HASHSIZE - 1);
-	found = false;
+	mac = brcmf_flowring_key(flow, da, prio, ifidx, &fifo, &sta);
+	hash_idx = brcmf_flowring_hash_idx(flow, mac, fifo, ifidx, sta);
 	hash = flow->hash;
-	for (i = 0; i < BRCMF_FLOWRING_HASHSIZE; i++) {
-		if ((hash[hash_idx].ifidx == BRCMF_FLOWRING_INVALID_IFIDX) &&
-		    (is_zero_ether_addr(hash[hash_idx].mac))) {
-			found = true;
+	for (probe = 0; probe < BRCMF_FLOWRING_HASHSIZE; probe++) {
+		if (hash[hash_idx].ifidx == BRCMF_FLOWRING_INVALID_IFIDX)
 			break;
-		}
 		hash_idx++;
-		hash_idx &= (BRCMF_FLOWRING_HASHSIZE - 1);
+		hash_idx &= BRCMF_FLOWRING_HASH_MASK;
 	}
-	if (found) {
-		for (i = 0; i < flow->nrofrings; i++) {
-			if (flow->rings[i] == NULL)
-				break;
-		}
-		if (i == flow->nrofrings)
-			return -ENOMEM;
+	if (probe == BRCMF_FLOWRING_HASHSIZE)
+		return BRCMF_FLOWRING_INVALID_ID;
 
-		ring = kzalloc(sizeof(*ring), GFP_ATOMIC);
-		if (!ring)
-			return -ENOMEM;
+	for (i = 0; i < flow->nrofrings; i++) {
+		if (flow->rings[i] == NULL)
+			break;
+	}
+	if (i == flow->nrofrings)
+		return BRCMF_FLOWRING_INVALID_ID;
 
-		memcpy(hash[hash_idx].mac, mac, ETH_ALEN);
-		hash[hash_idx].fifo = fifo;
-		hash[hash_idx].ifidx = ifidx;
-		hash[hash_idx].flowid = i;
+	ring = kzalloc(sizeof(*ring), GFP_ATOMIC);
+	if (!ring)
+		return BRCMF_FLOWRING_INVALID_ID;
 
-		ring->hash_id = hash_idx;
-		ring->status = RING_CLOSED;
-		skb_queue_head_init(&ring->skblist);
-		flow->rings[i] = ring;
+	if (hash[hash_idx].deleted) {
+		hash[hash_idx].deleted = false;
+		flow->hash_deleted--;
+	}
+	memcpy(hash[hash_idx].mac, mac, ETH_ALEN);
+	hash[hash_idx].fifo = fifo;
+	hash[hash_idx].ifidx = ifidx;
+	hash[hash_idx].flowid = i;
+	flow->hash_used++;
+	if (probe > flow->max_probe)
+		flow->max_probe = probe;
+
+	ring->hash_id = hash_idx;
+	ring->status = RING_CLOSED;
+	skb_queue_head_init(&ring->skblist);
+	flow->rings[i] = ring;
+
+	return i;
+}
 
-		return i;
+
+static void brcmf_flowring_hash_remove(struct brcmf_flowring *flow,
+				       u16 hash_idx)
+{
+	struct brcmf_flowring_hash *hash = flow->hash;
+	u32 i;
+
+	hash[hash_idx].ifidx = BRCMF_FLOWRING_INVALID_IFIDX;
+	eth_zero_addr(hash[hash_idx].mac);
+	flow->hash_used--;
+
+	if (!flow->hash_used) {
+		/* table is empty, drop all tombstones and start over */
+		for (i = 0; i < BRCMF_FLOWRING_HASHSIZE; i++)
+			hash[i].deleted = false;
+		flow->hash_deleted = 0;
+		flow->max_probe = 0;
+		return;
+	}
+
+	if (!brcmf_flowring_hash_empty(&hash[(hash_idx + 1) &
+					     BRCMF_FLOWRING_HASH_MASK])) {
+		hash[hash_idx].deleted = true;
+		flow->hash_deleted++;
+		return;
+	}
+
+	/* no chain continues past this slot, neither past the tombstones
+	 * directly in front of it
+	 */
+	hash_idx = (hash_idx - 1) & BRCMF_FLOWRING_HASH_MASK;
+	while (hash[hash_idx].deleted) {
+		hash[hash_idx].deleted = false;
+		flow->hash_deleted--;
+		hash_idx = (hash_idx - 1) & BRCMF_FLOWRING_HASH_MASK;
 	}
-	return BRCMF_FLOWRING_INVALID_ID;
 }
 
 
@@ -239,7 +300,6 @@ void brcmf_flowring_delete(struct brcmf_flowring *flow, u16 flowid)
 	struct brcmf_bus *bus_if = dev_get_drvdata(flow->dev);
 	struct brcmf_flowring_ring *ring;
 	struct brcmf_if *ifp;
-	u16 hash_idx;
 	u8 ifidx;
 	struct sk_buff *skb;
 
@@ -251,9 +311,7 @@ void brcmf_flowring_delete(struct brcmf_flowring *flow, u16 flowid)
 	ifp = brcmf_get_ifp(bus_if->drvr, ifidx);
 
 	brcmf_flowring_block(flow, flowid, false);
-	hash_idx = ring->hash_id;
-	flow->hash[hash_idx].ifidx = BRCMF_FLOWRING_INVALID_IFIDX;
-	eth_zero_addr(flow->hash[hash_idx].mac);
+	brcmf_flowring_hash_remove(flow, ring->hash_id);
 	flow->rings[flowid] = NULL;
 
 	skb = skb_dequeue(&ring->skblist);
@@ -270,14 +328,19 @@ u32 brcmf_flowring_enqueue(struct brcmf_flowring *flow, u16 flowid,
 			   struct sk_buff *skb)
 {
 	struct brcmf_flowring_ring *ring;
+	u32 qlen;
 
 	ring = flow->rings[flowid];
 
 	skb_queue_tail(&ring->skblist, skb);
 
-	if (!ring->blocked &&
-	    (skb_queue_len(&ring->skblist) > BRCMF_FLOWRING_HIGH)) {
+	qlen = skb_queue_len(&ring->skblist);
+	if (qlen > ring->qlen_max)
+		ring->qlen_max = qlen;
+
+	if (!ring->blocked && (qlen > BRCMF_FLOWRING_HIGH)) {
 		brcmf_flowring_block(flow, flowid, true);
+		ring->blocks++;
 		brcmf_dbg(MSGBUF, "Flowcontrol: BLOCK for ring %d\n", flowid);
 		/* To prevent (work around) possible race condition, check
 		 * queue len again. It is also possible to use locking to
@@ -375,6 +438,7 @@ struct brcmf_flowring *brcmf_flowring_attach(struct device *dev, u16 nrofrings)
 		flow->dev = dev;
 		flow->nrofrings = nrofrings;
 		spin_lock_init(&flow->block_lock);
+		get_random_bytes(&flow->hash_seed, sizeof(flow->hash_seed));
 		for (i = 0; i < ARRAY_SIZE(flow->addr_mode); i++)
 			flow->addr_mode[i] = ADDR_INDIRECT;
 		for (i = 0; i < ARRAY_SIZE(flow->hash); i++)
@@ -25,6 +25,7 @@ struct brcmf_flowring_hash {
 	u8 fifo;
 	u8 ifidx;
 	u16 flowid;
+	bool deleted;
 };
 
 enum ring_status {
@@ -38,6 +39,8 @@ struct brcmf_flowring_ring {
 	bool blocked;
 	enum ring_status status;
 	struct sk_buff_head skblist;
+	u32 qlen_max;
+	u32 blocks;
 };
 
 struct brcmf_flowring_tdls_entry {
@@ -48,6 +51,10 @@ struct brcmf_flowring_tdls_entry {
 struct brcmf_flowring {
 	struct device *dev;
 	struct brcmf_flowring_hash hash[BRCMF_FLOWRING_HASHSIZE];
+	u32 hash_seed;
+	u16 hash_used;
+	u16 hash_deleted;
+	u16 max_probe;
 	struct brcmf_flowring_ring **rings;
 	spinlock_t block_lock;
 	enum proto_addr_mode addr_mode[BRCMF_MAX_IFS];
@@ -268,16 +268,23 @@ struct brcmf_msgbuf {
 };
 
 struct brcmf_msgbuf_pktid {
-	atomic_t  allocated;
 	u16 data_offset;
 	struct sk_buff *skb;
 	dma_addr_t physaddr;
 };
 
+/*
+ * Packet ids are handed out from a bitmap: a set bit marks a slot that is
+ * owned by the firmware. Allocation claims the first clear bit following
+ * the last allocated id with test_and_set_bit(), so concurrent allocators
+ * never need a lock and a slot is found one word at a time instead of
+ * probing every entry of the array.
+ */
 struct brcmf_msgbuf_pktids {
 	u32 array_size;
 	u32 last_allocated_idx;
 	enum dma_data_direction direction;
+	unsigned long *map;
 	struct brcmf_msgbuf_pktid *array;
 };
 
@@ -290,20 +297,63 @@ brcmf_msgbuf_init_pktids(u32 nr_array_entries,
 {
 	struct brcmf_msgbuf_pktid *array;
 	struct brcmf_msgbuf_pktids *pktids;
+	unsigned long *map;
 
 	array = kcalloc(nr_array_entries, sizeof(*array), GFP_KERNEL);
 	if (!array)
 		return NULL;
 
+	map = kcalloc(BITS_TO_LONGS(nr_array_entries), sizeof(*map),
+		      GFP_KERNEL);
+	if (!map)
+		goto free_array;
+
 	pktids = kzalloc(sizeof(*pktids), GFP_KERNEL);
-	if (!pktids) {
-		kfree(array);
-		return NULL;
-	}
+	if (!pktids)
+		goto free_map;
+
 	pktids->array = array;
+	pktids->map = map;
 	pktids->array_size = nr_array_entries;
+	pktids->direction = direction;
 
 	return pktids;
+
+free_map:
+	kfree(map);
+free_array:
+	kfree(array);
+	return NULL;
+}
+
+
+static int
+brcmf_msgbuf_reserve_pktid(struct brcmf_msgbuf_pktids *pktids, u32 *idx)
+{
+	u32 size = pktids->array_size;
+	u32 start, slot;
+
+	start = READ_ONCE(pktids->last_allocated_idx) + 1;
+	if (start >= size)
+		start = 0;
+
+	do {
+		slot = find_next_zero_bit(pktids->map, size, start);
+		if (slot >= size) {
+			slot = find_first_zero_bit(pktids->map, size);
+			if (slot >= size)
+				return -ENOMEM;
+		}
+		/* lost the race for this slot, try the next clear one */
+		start = slot + 1;
+		if (start >= size)
+			start = 0;
+	} while (test_and_set_bit(slot, pktids->map));
+
+	WRITE_ONCE(pktids->last_allocated_idx, slot);
+	*idx = slot;
+
+	return 0;
 }
 
 
@@ -313,40 +363,24 @@ brcmf_msgbuf_alloc_pktid(struct device *dev,
 			 struct sk_buff *skb, u16 data_offset,
 			 dma_addr_t *physaddr, u32 *idx)
 {
-	struct brcmf_msgbuf_pktid *array;
-	u32 count;
+	struct brcmf_msgbuf_pktid *pktid;
 
-	array = pktids->array;
+	if (brcmf_msgbuf_reserve_pktid(pktids, idx))
+		return -ENOMEM;
 
 	*physaddr = dma_map_single(dev, skb->data + data_offset,
 				   skb->len - data_offset, pktids->direction);
 
 	if (dma_mapping_error(dev, *physaddr)) {
 		brcmf_err("dma_map_single failed !!\n");
+		clear_bit(*idx, pktids->map);
 		return -ENOMEM;
 	}
 
-	*idx = pktids->last_allocated_idx;
-
-	count = 0;
-	do {
-		(*idx)++;
-		if (*idx == pktids->array_size)
-			*idx = 0;
-		if (array[*idx].allocated.counter == 0)
-			if (atomic_cmpxchg(&array[*idx].allocated, 0, 1) == 0)
-				break;
-		count++;
-	} while (count < pktids->array_size);
-
-	if (count == pktids->array_size)
-		return -ENOMEM;
-
-	array[*idx].data_offset = data_offset;
-	array[*idx].physaddr = *physaddr;
-	array[*idx].skb = skb;
-
-	pktids->last_allocated_idx = *idx;
+	pktid = &pktids->array[*idx];
+	pktid->data_offset = data_offset;
+	pktid->physaddr = *physaddr;
+	pktid->skb = skb;
 
 	return 0;
 }
@@ -364,13 +398,14 @@ brcmf_msgbuf_get_pktid(struct device *dev, struct brcmf_msgbuf_pktids *pktids,
 			  pktids->array_size);
 		return NULL;
 	}
-	if (pktids->array[idx].allocated.counter) {
+	if (test_bit(idx, pktids->map)) {
 		pktid = &pktids->array[idx];
 		dma_unmap_single(dev, pktid->physaddr,
 				 pktid->skb->len - pktid->data_offset,
 				 pktids->direction);
 		skb = pktid->skb;
-		pktid->allocated.counter = 0;
+		pktid->skb = NULL;
+		clear_bit_unlock(idx, pktids->map);
 		return skb;
 	} else {
 		brcmf_err("Invalid packet id %d (not in use)\n", idx);
@@ -384,24 +419,19 @@ static void
 brcmf_msgbuf_release_array(struct device *dev,
 			   struct brcmf_msgbuf_pktids *pktids)
 {
-	struct brcmf_msgbuf_pktid *array;
 	struct brcmf_msgbuf_pktid *pktid;
-	u32 count;
+	u32 idx;
 
-	array = pktids->array;
-	count = 0;
-	do {
-		if (array[count].allocated.counter) {
-			pktid = &array[count];
-			dma_unmap_single(dev, pktid->physaddr,
-					 pktid->skb->len - pktid->data_offset,
-					 pktids->direction);
-			brcmu_pkt_buf_free_skb(pktid->skb);
-		}
-		count++;
-	} while (count < pktids->array_size);
+	for_each_set_bit(idx, pktids->map, pktids->array_size) {
+		pktid = &pktids->array[idx];
+		dma_unmap_single(dev, pktid->physaddr,
+				 pktid->skb->len - pktid->data_offset,
+				 pktids->direction);
+		brcmu_pkt_buf_free_skb(pktid->skb);
+	}
 
-	kfree(array);
+	kfree(pktids->map);
+	kfree(pktids->array);
 	kfree(pktids);
 }
 
@@ -1410,6 +1440,9 @@ static int brcmf_msgbuf_stats_read(struct seq_file *seq, void *data)
 
 	seq_printf(seq, "\nh2d_flowrings: depth %u\n",
 		   BRCMF_H2D_TXFLOWRING_MAX_ITEM);
+	seq_printf(seq, "flow hash: used %u, deleted %u, max probe %u\n",
+		   msgbuf->flow->hash_used, msgbuf->flow->hash_deleted,
+		   msgbuf->flow->max_probe);
 	seq_puts(seq, "Active flowrings:\n");
 	hash = msgbuf->flow->hash;
 	for (i = 0; i < msgbuf->flow->nrofrings; i++) {
@@ -1421,10 +1454,12 @@ static int brcmf_msgbuf_stats_read(struct seq_file *seq, void *data)
 		commonring = msgbuf->flowrings[i];
 		hash = &msgbuf->flow->hash[ring->hash_id];
 		seq_printf(seq, "id %3u: rp %4u, wp %4u, qlen %4u, blocked %u\n"
-				"        ifidx %u, fifo %u, da %pM\n",
+				"        ifidx %u, fifo %u, da %pM\n"
+				"        qlen max %u, blocks %u\n",
 				i, commonring->r_ptr, commonring->w_ptr,
 				skb_queue_len(&ring->skblist), ring->blocked,
-				hash->ifidx, hash->fifo, hash->mac);
+				hash->ifidx, hash->fifo, hash->mac,
+				ring->qlen_max, ring->blocks);
 	}
 
 	return 0;
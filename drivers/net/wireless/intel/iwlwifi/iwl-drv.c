@@ -116,6 +116,7 @@ struct iwl_drv {
 
 	int fw_index;                   /* firmware we're trying to load */
 	char firmware_name[64];         /* name of firmware file to load */
+	const struct firmware *fw_raw;	/* kept file, sections point here */
 
 	struct completion request_firmware_complete;
 
@@ -156,7 +157,8 @@ struct fw_sec {
 
 static void iwl_free_fw_desc(struct iwl_drv *drv, struct fw_desc *desc)
 {
-	vfree(desc->data);
+	if (!drv->fw_raw)
+		vfree(desc->data);
 	desc->data = NULL;
 	desc->len = 0;
 }
@@ -183,6 +185,9 @@ static void iwl_dealloc_ucode(struct iwl_drv *drv)
 
 	for (i = 0; i < IWL_UCODE_TYPE_MAX; i++)
 		iwl_free_fw_img(drv, drv->fw.img + i);
+
+	release_firmware(drv->fw_raw);
+	drv->fw_raw = NULL;
 }
 
 static int iwl_alloc_fw_desc(struct iwl_drv *drv, struct fw_desc *desc,
@@ -195,6 +200,14 @@ static int iwl_alloc_fw_desc(struct iwl_drv *drv, struct fw_desc *desc,
 	if (!sec || !sec->size)
 		return -EINVAL;
 
+	/* the firmware file is kept, use the section in place */
+	if (drv->fw_raw) {
+		desc->len = sec->size;
+		desc->offset = sec->offset;
+		desc->data = sec->data;
+		return 0;
+	}
+
 	data = vmalloc(sec->size);
 	if (!data)
 		return -ENOMEM;
@@ -1332,6 +1345,18 @@ static void iwl_req_fw_callback(const struct firmware *ucode_raw, void *context)
 							 drv->trans->cfg))
 		goto try_again;
 
+	/*
+	 * Unless asked to keep the file loaded, every section is copied out
+	 * of it below and the file is released once parsing is done. When
+	 * it is kept, the image descriptors point into the file directly,
+	 * which saves the copies and the transient double memory use. The
+	 * whole file then stays resident for the lifetime of the device,
+	 * including images that are never loaded and the TLV headers, so
+	 * steady state memory use is not lower.
+	 */
+	if (iwlwifi_mod_params.fw_keep_image)
+		drv->fw_raw = ucode_raw;
+
 	/* Allocate ucode buffers for card's bus-master loading ... */
 
 	/* Runtime instructions and 2 copies of data:
@@ -1484,7 +1509,8 @@ static void iwl_req_fw_callback(const struct firmware *ucode_raw, void *context)
 			IWL_MAX_STANDARD_PHY_CALIBRATE_TBL_SIZE;
 
 	/* We have our copies now, allow OS release its copies */
-	release_firmware(ucode_raw);
+	if (!drv->fw_raw)
+		release_firmware(ucode_raw);
 
 	mutex_lock(&iwlwifi_opmode_table_mtx);
 	switch (fw->type) {
@@ -1547,8 +1573,10 @@ static void iwl_req_fw_callback(const struct firmware *ucode_raw, void *context)
 	goto free;
 
  out_free_fw:
+	/* a kept file is released along with the images */
+	if (!drv->fw_raw)
+		release_firmware(ucode_raw);
 	iwl_dealloc_ucode(drv);
-	release_firmware(ucode_raw);
  out_unbind:
 	complete(&drv->request_firmware_complete);
 	device_release_driver(drv->trans->dev);
@@ -1807,6 +1835,11 @@ module_param_named(fw_monitor, iwlwifi_mod_params.fw_monitor, bool, 0444);
 MODULE_PARM_DESC(fw_monitor,
 		 "firmware monitor - to debug FW (default: false - needs lots of memory)");
 
+module_param_named(fw_keep_image, iwlwifi_mod_params.fw_keep_image, bool,
+		   0444);
+MODULE_PARM_DESC(fw_keep_image,
+		 "keep the whole firmware file resident instead of copying its sections; avoids the copies and the load time peak, not the resident size (default: false)");
+
 module_param_named(d0i3_timeout, iwlwifi_mod_params.d0i3_timeout, uint, 0444);
 MODULE_PARM_DESC(d0i3_timeout, "Timeout to D0i3 entry when idle (ms)");
 
@@ -123,6 +123,8 @@ enum iwl_uapsd_disable {
  *	entering D0i3 (in msecs)
  * @lar_disable: disable LAR (regulatory), default = 0
  * @fw_monitor: allow to use firmware monitor
+ * @fw_keep_image: keep the whole firmware file resident and use its
+ *	sections in place instead of copying them, default = false
  * @disable_11ac: disable VHT capabilities, default = false.
  * @remove_when_gone: remove an inaccessible device from the PCIe bus.
  */
@@ -145,6 +147,7 @@ struct iwl_mod_params {
 	unsigned int d0i3_timeout;
 	bool lar_disable;
 	bool fw_monitor;
+	bool fw_keep_image;
 	bool disable_11ac;
 	/**
 	 * @disable_11ax: disable HE capabilities, default = false
@@ -204,6 +204,22 @@ struct iwl_rx_completion_desc {
 	u8 reserved2[22];
 } __packed;
 
+/**
+ * struct iwl_rxq_stats - Rx queue refill statistics
+ * @refills: RBD batches claimed from the allocator
+ * @starved: waits in which the allocator had no batch ready at first
+ * @emergency: times the queue ran low and fell back to atomic allocation
+ * @wait_max_us: longest wait for a batch from the allocator
+ * @wait_total_us: total time spent waiting for batches from the allocator
+ */
+struct iwl_rxq_stats {
+	u32 refills;
+	u32 starved;
+	u32 emergency;
+	u32 wait_max_us;
+	u64 wait_total_us;
+};
+
 /**
  * struct iwl_rxq - Rx queue
  * @id: queue index
@@ -229,6 +245,10 @@ struct iwl_rx_completion_desc {
  * @rb_stts_dma: bus address of receive buffer status
  * @lock:
  * @queue: actual rx queue. Not used for multi-rx queue.
+ * @refill_start: time the queue started waiting for the allocator, 0 if the
+ *	queue is not waiting
+ * @refill_starved: the allocator had no batch ready during the current wait
+ * @stats: refill statistics
  *
  * NOTE:  rx_free and rx_used are used as a FIFO for iwl_rx_mem_buffers
  */
@@ -260,6 +280,9 @@ struct iwl_rxq {
 	spinlock_t lock;
 	struct napi_struct napi;
 	struct iwl_rx_mem_buffer *queue[RX_QUEUE_SIZE];
+	ktime_t refill_start;
+	bool refill_starved;
+	struct iwl_rxq_stats stats;
 };
 
 /**
@@ -587,17 +587,23 @@ static void iwl_pcie_rx_allocator(struct iwl_trans *trans)
 .* Called by queue when the queue posted allocation request and
  * has freed 8 RBDs in order to restock itself.
  * This function directly moves the allocated RBs to the queue's ownership
- * and updates the relevant counters.
+ * and updates the relevant counters. All batches that are ready and owed to
+ * the queue are claimed under a single hold of the allocator lock.
  */
 static void iwl_pcie_rx_allocator_get(struct iwl_trans *trans,
 				      struct iwl_rxq *rxq)
 {
 	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
 	struct iwl_rb_allocator *rba = &trans_pcie->rba;
+	u32 wait_us;
+	ktime_t now;
 	int i;
 
 	lockdep_assert_held(&rxq->lock);
 
+	if (!rxq->refill_start)
+		rxq->refill_start = ktime_get();
+
 	/*
 	 * atomic_dec_if_positive returns req_ready - 1 for any scenario.
 	 * If req_ready is 0 atomic_dec_if_positive will return -1 and this
@@ -606,22 +612,42 @@ static void iwl_pcie_rx_allocator_get(struct iwl_trans *trans,
 	 * req_ready > 0, i.e. - there are ready requests and the function
 	 * hands one request to the caller.
 	 */
-	if (atomic_dec_if_positive(&rba->req_ready) < 0)
+	if (atomic_dec_if_positive(&rba->req_ready) < 0) {
+		if (!rxq->refill_starved) {
+			rxq->refill_starved = true;
+			rxq->stats.starved++;
+		}
 		return;
+	}
 
 	spin_lock(&rba->lock);
-	for (i = 0; i < RX_CLAIM_REQ_ALLOC; i++) {
-		/* Get next free Rx buffer, remove it from free list */
-		struct iwl_rx_mem_buffer *rxb =
-			list_first_entry(&rba->rbd_allocated,
-					 struct iwl_rx_mem_buffer, list);
+	do {
+		for (i = 0; i < RX_CLAIM_REQ_ALLOC; i++) {
+			/* Get next free Rx buffer, remove it from free list */
+			struct iwl_rx_mem_buffer *rxb =
+				list_first_entry(&rba->rbd_allocated,
+						 struct iwl_rx_mem_buffer,
+						 list);
+
+			list_move(&rxb->list, &rxq->rx_free);
+		}
 
-		list_move(&rxb->list, &rxq->rx_free);
-	}
+		rxq->used_count -= RX_CLAIM_REQ_ALLOC;
+		rxq->free_count += RX_CLAIM_REQ_ALLOC;
+		rxq->stats.refills++;
+	} while (rxq->used_count >= RX_CLAIM_REQ_ALLOC &&
+		 atomic_dec_if_positive(&rba->req_ready) >= 0);
 	spin_unlock(&rba->lock);
 
-	rxq->used_count -= RX_CLAIM_REQ_ALLOC;
-	rxq->free_count += RX_CLAIM_REQ_ALLOC;
+	now = ktime_get();
+	wait_us = ktime_us_delta(now, rxq->refill_start);
+	rxq->stats.wait_total_us += wait_us;
+	if (wait_us > rxq->stats.wait_max_us)
+		rxq->stats.wait_max_us = wait_us;
+
+	/* still owed a batch, the next wait starts now */
+	rxq->refill_start = rxq->used_count >= RX_CLAIM_REQ_ALLOC ? now : 0;
+	rxq->refill_starved = false;
 }
 
 void iwl_pcie_rx_allocator_work(struct work_struct *data)
@@ -994,6 +1020,8 @@ void iwl_pcie_rx_init_rxb_lists(struct iwl_rxq *rxq)
 	INIT_LIST_HEAD(&rxq->rx_used);
 	rxq->free_count = 0;
 	rxq->used_count = 0;
+	rxq->refill_start = 0;
+	rxq->refill_starved = false;
 }
 
 int iwl_pcie_dummy_napi_poll(struct napi_struct *napi, int budget)
@@ -1398,8 +1426,11 @@ static void iwl_pcie_rx_handle(struct iwl_trans *trans, int queue)
 	while (i != r) {
 		struct iwl_rx_mem_buffer *rxb;
 
-		if (unlikely(rxq->used_count == rxq->queue_size / 2))
+		if (unlikely(rxq->used_count == rxq->queue_size / 2) &&
+		    !emergency) {
 			emergency = true;
+			rxq->stats.emergency++;
+		}
 
 		rxb = iwl_pcie_get_rxb(trans, rxq, i);
 		if (!rxb)
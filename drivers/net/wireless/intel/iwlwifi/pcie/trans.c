@@ -2514,7 +2514,7 @@ static ssize_t iwl_dbgfs_rx_queue_read(struct file *file,
 	int pos = 0, i, ret;
 	size_t bufsz = sizeof(buf);
 
-	bufsz = sizeof(char) * 121 * trans->num_rx_queues;
+	bufsz = sizeof(char) * 281 * trans->num_rx_queues;
 
 	if (!trans_pcie->rxq)
 		return -EAGAIN;
@@ -2548,6 +2548,18 @@ static ssize_t iwl_dbgfs_rx_queue_read(struct file *file,
 			pos += scnprintf(buf + pos, bufsz - pos,
 					 "\tclosed_rb_num: Not Allocated\n");
 		}
+		pos += scnprintf(buf + pos, bufsz - pos, "\trefills: %u\n",
+				 rxq->stats.refills);
+		pos += scnprintf(buf + pos, bufsz - pos, "\tstarved: %u\n",
+				 rxq->stats.starved);
+		pos += scnprintf(buf + pos, bufsz - pos, "\temergency: %u\n",
+				 rxq->stats.emergency);
+		pos += scnprintf(buf + pos, bufsz - pos,
+				 "\trefill_wait_max: %u us\n",
+				 rxq->stats.wait_max_us);
+		pos += scnprintf(buf + pos, bufsz - pos,
+				 "\trefill_wait_total: %llu us\n",
+				 rxq->stats.wait_total_us);
 	}
 	ret = simple_read_from_buffer(user_buf, count, ppos, buf, pos);
 	kfree(buf);
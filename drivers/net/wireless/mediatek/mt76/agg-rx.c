@@ -29,6 +29,7 @@ mt76_aggr_release(struct mt76_rx_tid *tid, struct sk_buff_head *frames, int idx)
 		return;
 
 	tid->reorder_buf[idx] = NULL;
+	__clear_bit(idx, tid->reorder_busy);
 	tid->nframes--;
 	__skb_queue_tail(frames, skb);
 }
@@ -40,6 +41,13 @@ mt76_rx_aggr_release_frames(struct mt76_rx_tid *tid, struct sk_buff_head *frames
 	int idx;
 
 	while (ieee80211_sn_less(tid->head, head)) {
+		/* move over a run of empty slots in one go */
+		tid->head = ieee80211_reorder_skip_empty(tid->reorder_busy,
+							 tid->size, tid->head,
+							 head);
+		if (tid->head == head)
+			break;
+
 		idx = tid->head % tid->size;
 		mt76_aggr_release(tid, frames, idx);
 	}
@@ -61,7 +69,7 @@ mt76_rx_aggr_check_release(struct mt76_rx_tid *tid, struct sk_buff_head *frames)
 {
 	struct mt76_rx_status *status;
 	struct sk_buff *skb;
-	int start, idx, nframes;
+	int start, idx, nframes, skip;
 
 	if (!tid->nframes)
 		return;
@@ -74,10 +82,13 @@ mt76_rx_aggr_check_release(struct mt76_rx_tid *tid, struct sk_buff_head *frames)
 	for (idx = (tid->head + 1) % tid->size;
 	     idx != start && nframes;
 	     idx = (idx + 1) % tid->size) {
+		skip = ieee80211_reorder_next_busy(tid->reorder_busy,
+						   tid->size, idx);
+		if (skip >= (start - idx + tid->size) % tid->size)
+			break;
 
+		idx = (idx + skip) % tid->size;
 		skb = tid->reorder_buf[idx];
-		if (!skb)
-			continue;
 
 		nframes--;
 		status = (struct mt76_rx_status *) skb->cb;
@@ -230,6 +241,7 @@ void mt76_rx_aggr_reorder(struct sk_buff *skb, struct sk_buff_head *frames)
 
 	status->reorder_time = jiffies;
 	tid->reorder_buf[idx] = skb;
+	__set_bit(idx, tid->reorder_busy);
 	tid->nframes++;
 	mt76_rx_aggr_release_head(tid, frames);
 
@@ -272,14 +284,9 @@ static void mt76_rx_aggr_shutdown(struct mt76_dev *dev, struct mt76_rx_tid *tid)
 	spin_lock_bh(&tid->lock);
 
 	tid->stopped = true;
-	for (i = 0; tid->nframes && i < size; i++) {
-		struct sk_buff *skb = tid->reorder_buf[i];
-
-		if (!skb)
-			continue;
-
+	for_each_set_bit(i, tid->reorder_busy, size) {
 		tid->nframes--;
-		dev_kfree_skb(skb);
+		dev_kfree_skb(tid->reorder_buf[i]);
 	}
 
 	spin_unlock_bh(&tid->lock);
@@ -53,6 +53,18 @@ mt76_queues_read(struct seq_file *s, void *data)
 			   i, q->queued, q->head, q->tail, q->swq_queued);
 	}
 
+	for (i = 0; i < ARRAY_SIZE(dev->q_rx); i++) {
+		struct mt76_queue *q = &dev->q_rx[i];
+
+		if (!q->page_pool)
+			continue;
+
+		seq_printf(s,
+			   "rx%d:	queued=%d head=%d tail=%d page_recycle=%u page_release=%u\n",
+			   i, q->queued, q->head, q->tail, q->rx_page_recycle,
+			   q->rx_page_release);
+	}
+
 	return 0;
 }
 
@@ -66,6 +78,7 @@ struct dentry *mt76_register_debugfs(struct mt76_dev *dev)
 
 	debugfs_create_u8("led_pin", 0600, dir, &dev->led_pin);
 	debugfs_create_u32("regidx", 0600, dir, &dev->debugfs_reg);
+	debugfs_create_u32("rx_copybreak", 0600, dir, &dev->rx_copybreak);
 	debugfs_create_file_unsafe("regval", 0600, dir, dev,
 				   &fops_regval);
 	debugfs_create_blob("eeprom", 0400, dir, &dev->eeprom);
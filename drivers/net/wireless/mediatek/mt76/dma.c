@@ -15,11 +15,47 @@
  */
 
 #include <linux/dma-mapping.h>
+#include <net/page_pool.h>
 #include "mt76.h"
 #include "dma.h"
 
 #define DMA_DUMMY_TXWI	((void *) ~0)
 
+/* FIFO entries looked at for a free page on each refill */
+#define MT_DMA_RX_RECLAIM_SCAN	8
+
+static int
+mt76_dma_alloc_page_pool(struct mt76_dev *dev, struct mt76_queue *q)
+{
+	struct page_pool_params pp_params = {
+		.order = 0,
+		.flags = PP_FLAG_DMA_MAP,
+		.pool_size = q->ndesc,
+		.nid = dev_to_node(dev->dev),
+		.dev = dev->dev,
+		.dma_dir = DMA_FROM_DEVICE,
+	};
+
+	/* rx buffers are carved out of single pages */
+	if (WARN_ON(q->buf_size > PAGE_SIZE))
+		return -EINVAL;
+
+	q->rx_inflight = devm_kcalloc(dev->dev, q->ndesc,
+				      sizeof(*q->rx_inflight), GFP_KERNEL);
+	if (!q->rx_inflight)
+		return -ENOMEM;
+
+	q->page_pool = page_pool_create(&pp_params);
+	if (IS_ERR(q->page_pool)) {
+		int ret = PTR_ERR(q->page_pool);
+
+		q->page_pool = NULL;
+		return ret;
+	}
+
+	return 0;
+}
+
 static int
 mt76_dma_alloc_queue(struct mt76_dev *dev, struct mt76_queue *q)
 {
@@ -48,6 +84,9 @@ mt76_dma_alloc_queue(struct mt76_dev *dev, struct mt76_queue *q)
 	iowrite32(0, &q->regs->dma_idx);
 	iowrite32(q->ndesc, &q->regs->ring_size);
 
+	if (q->buf_size)
+		return mt76_dma_alloc_page_pool(dev, q);
+
 	return 0;
 }
 
@@ -196,7 +235,7 @@ mt76_dma_get_buf(struct mt76_dev *dev, struct mt76_queue *q, int idx,
 	struct mt76_desc *desc = &q->desc[idx];
 	dma_addr_t buf_addr;
 	void *buf = e->buf;
-	int buf_len = SKB_WITH_OVERHEAD(q->buf_size);
+	int buf_len = SKB_WITH_OVERHEAD(q->buf_size) - q->buf_offset;
 
 	buf_addr = le32_to_cpu(READ_ONCE(desc->buf0));
 	if (len) {
@@ -208,7 +247,8 @@ mt76_dma_get_buf(struct mt76_dev *dev, struct mt76_queue *q, int idx,
 	if (info)
 		*info = le32_to_cpu(desc->info);
 
-	dma_unmap_single(dev->dev, buf_addr, buf_len, DMA_FROM_DEVICE);
+	/* the page stays mapped for as long as it belongs to the pool */
+	dma_sync_single_for_cpu(dev->dev, buf_addr, buf_len, DMA_FROM_DEVICE);
 	e->buf = NULL;
 
 	return buf;
@@ -313,36 +353,135 @@ int mt76_dma_tx_queue_skb(struct mt76_dev *dev, struct mt76_queue *q,
 }
 EXPORT_SYMBOL_GPL(mt76_dma_tx_queue_skb);
 
+/*
+ * Rx buffers are buf_size slices of pages that stay owned by the rx page
+ * pool. The queue holds the page's own reference, every slice holds one
+ * more for as long as it sits in a descriptor or in an skb. Slices are
+ * carved in ring order, so once the last slice of a page comes off the
+ * ring the device is done with the page, and it goes into a small FIFO.
+ * Refills reuse a page from the FIFO as is, still DMA mapped, as soon as
+ * the stack has dropped all of its slices, meaning its refcount is back
+ * to one. Pages still busy when the FIFO is full go back through
+ * page_pool_put_page() and get unmapped.
+ *
+ * The FIFO is only used from the NAPI poll of the queue.
+ */
+static struct page *
+mt76_dma_rx_reclaim_page(struct mt76_queue *q)
+{
+	int i, n = min_t(int, q->rx_inflight_count, MT_DMA_RX_RECLAIM_SCAN);
+
+	/* look past pages the stack still holds */
+	for (i = 0; i < n; i++) {
+		int idx = (q->rx_inflight_head + i) % q->ndesc;
+		struct page *page = q->rx_inflight[idx];
+
+		if (page_ref_count(page) != 1)
+			continue;
+
+		q->rx_inflight[idx] = q->rx_inflight[q->rx_inflight_head];
+		q->rx_inflight_head = (q->rx_inflight_head + 1) % q->ndesc;
+		q->rx_inflight_count--;
+		q->rx_page_recycle++;
+
+		return page;
+	}
+
+	return NULL;
+}
+
+static void
+mt76_dma_rx_evict_page(struct mt76_queue *q, bool allow_direct)
+{
+	struct page *page = q->rx_inflight[q->rx_inflight_head];
+
+	q->rx_inflight_head = (q->rx_inflight_head + 1) % q->ndesc;
+	q->rx_inflight_count--;
+
+	/* still in use by the stack, the pool unmaps it */
+	if (page_ref_count(page) != 1)
+		q->rx_page_release++;
+
+	page_pool_put_page(q->page_pool, page, allow_direct);
+}
+
+static void
+mt76_dma_rx_lend_page(struct mt76_queue *q, struct page *page)
+{
+	if (q->rx_inflight_count == q->ndesc)
+		mt76_dma_rx_evict_page(q, true);
+
+	q->rx_inflight[(q->rx_inflight_head + q->rx_inflight_count) %
+		       q->ndesc] = page;
+	q->rx_inflight_count++;
+}
+
+static bool
+mt76_dma_rx_last_buf(struct mt76_queue *q, void *buf)
+{
+	int offset = buf - page_address(virt_to_head_page(buf));
+
+	return offset + 2 * q->buf_size > PAGE_SIZE;
+}
+
+/* drop the reference of a slice, the page itself stays with the queue */
+static void
+mt76_dma_rx_put_buf(void *buf)
+{
+	page_ref_dec(virt_to_head_page(buf));
+}
+
+static void *
+mt76_dma_rx_get_buf(struct mt76_queue *q)
+{
+	void *buf;
+
+	if (!q->rx_page) {
+		q->rx_page = mt76_dma_rx_reclaim_page(q);
+		if (!q->rx_page)
+			q->rx_page = page_pool_dev_alloc_pages(q->page_pool);
+		if (!q->rx_page)
+			return NULL;
+
+		q->rx_page_offset = 0;
+	}
+
+	buf = page_address(q->rx_page) + q->rx_page_offset;
+	page_ref_inc(q->rx_page);
+
+	q->rx_page_offset += q->buf_size;
+	if (q->rx_page_offset + q->buf_size > PAGE_SIZE)
+		q->rx_page = NULL;
+
+	return buf;
+}
+
 static int
-mt76_dma_rx_fill(struct mt76_dev *dev, struct mt76_queue *q, bool napi)
+mt76_dma_rx_fill(struct mt76_dev *dev, struct mt76_queue *q)
 {
 	dma_addr_t addr;
-	void *buf;
+	struct page *page;
 	int frames = 0;
 	int len = SKB_WITH_OVERHEAD(q->buf_size);
 	int offset = q->buf_offset;
 	int idx;
-	void *(*alloc)(unsigned int fragsz);
-
-	if (napi)
-		alloc = napi_alloc_frag;
-	else
-		alloc = netdev_alloc_frag;
 
 	spin_lock_bh(&q->lock);
 
 	while (q->queued < q->ndesc - 1) {
 		struct mt76_queue_buf qbuf;
+		void *buf;
 
-		buf = alloc(q->buf_size);
+		buf = mt76_dma_rx_get_buf(q);
 		if (!buf)
 			break;
 
-		addr = dma_map_single(dev->dev, buf, len, DMA_FROM_DEVICE);
-		if (dma_mapping_error(dev->dev, addr)) {
-			skb_free_frag(buf);
-			break;
-		}
+		page = virt_to_head_page(buf);
+		addr = page_private(page) + (buf - page_address(page));
+
+		/* recycled pages may still have dirty cache lines */
+		dma_sync_single_for_device(dev->dev, addr + offset,
+					   len - offset, DMA_FROM_DEVICE);
 
 		qbuf.addr = addr + offset;
 		qbuf.len = len - offset;
@@ -370,11 +509,27 @@ mt76_dma_rx_cleanup(struct mt76_dev *dev, struct mt76_queue *q)
 		if (!buf)
 			break;
 
-		skb_free_frag(buf);
+		mt76_dma_rx_put_buf(buf);
+		if (mt76_dma_rx_last_buf(q, buf))
+			page_pool_put_page(q->page_pool,
+					   virt_to_head_page(buf), false);
 	} while (1);
+
+	/* the rest of a partly carved page was never handed out */
+	if (q->rx_page) {
+		page_pool_put_page(q->page_pool, q->rx_page, false);
+		q->rx_page = NULL;
+	}
 	spin_unlock_bh(&q->lock);
 }
 
+static void
+mt76_dma_rx_free_inflight(struct mt76_queue *q)
+{
+	while (q->rx_inflight_count)
+		mt76_dma_rx_evict_page(q, false);
+}
+
 static void
 mt76_dma_rx_reset(struct mt76_dev *dev, enum mt76_rxq_id qid)
 {
@@ -386,7 +541,7 @@ mt76_dma_rx_reset(struct mt76_dev *dev, enum mt76_rxq_id qid)
 
 	mt76_dma_rx_cleanup(dev, q);
 	mt76_dma_sync_idx(dev, q);
-	mt76_dma_rx_fill(dev, q, false);
+	mt76_dma_rx_fill(dev, q);
 }
 
 static void
@@ -408,9 +563,42 @@ mt76_add_fragment(struct mt76_dev *dev, struct mt76_queue *q, void *data,
 	dev->drv->rx_skb(dev, q - dev->q_rx, skb);
 }
 
+static struct sk_buff *
+mt76_dma_rx_copy(struct mt76_dev *dev, struct mt76_queue *q, void *data,
+		 int len)
+{
+	struct napi_struct *napi = &dev->napi[q - dev->q_rx];
+	struct sk_buff *skb;
+
+	skb = napi_alloc_skb(napi, len);
+	if (!skb)
+		return NULL;
+
+	skb_put_data(skb, data + q->buf_offset, len);
+
+	return skb;
+}
+
+static struct sk_buff *
+mt76_dma_rx_build_skb(struct mt76_dev *dev, struct mt76_queue *q, void *data)
+{
+	struct sk_buff *skb;
+
+	skb = build_skb(data, q->buf_size);
+	if (!skb) {
+		skb_free_frag(data);
+		return NULL;
+	}
+
+	skb_reserve(skb, q->buf_offset);
+
+	return skb;
+}
+
 static int
 mt76_dma_rx_process(struct mt76_dev *dev, struct mt76_queue *q, int budget)
 {
+	int max_len = SKB_WITH_OVERHEAD(q->buf_size) - q->buf_offset;
 	struct sk_buff *skb;
 	unsigned char *data;
 	int len;
@@ -424,29 +612,40 @@ mt76_dma_rx_process(struct mt76_dev *dev, struct mt76_queue *q, int budget)
 		if (!data)
 			break;
 
+		if (mt76_dma_rx_last_buf(q, data))
+			mt76_dma_rx_lend_page(q, virt_to_head_page(data));
+
 		if (q->rx_head) {
 			mt76_add_fragment(dev, q, data, len, more);
 			continue;
 		}
 
-		skb = build_skb(data, q->buf_size);
-		if (!skb) {
-			skb_free_frag(data);
+		if (len > max_len) {
+			mt76_dma_rx_put_buf(data);
 			continue;
 		}
 
-		skb_reserve(skb, q->buf_offset);
-		if (skb->tail + len > skb->end) {
-			dev_kfree_skb(skb);
-			continue;
+		/*
+		 * Small single-buffer frames are copied, which frees the
+		 * slice right away.
+		 */
+		if (!more && len <= dev->rx_copybreak) {
+			skb = mt76_dma_rx_copy(dev, q, data, len);
+			mt76_dma_rx_put_buf(data);
+		} else {
+			skb = mt76_dma_rx_build_skb(dev, q, data);
+			if (skb)
+				__skb_put(skb, len);
 		}
 
+		if (!skb)
+			continue;
+
 		if (q == &dev->q_rx[MT_RXQ_MCU]) {
 			u32 *rxfce = (u32 *) skb->cb;
 			*rxfce = info;
 		}
 
-		__skb_put(skb, len);
 		done++;
 
 		if (more) {
@@ -457,7 +656,7 @@ mt76_dma_rx_process(struct mt76_dev *dev, struct mt76_queue *q, int budget)
 		dev->drv->rx_skb(dev, q - dev->q_rx, skb);
 	}
 
-	mt76_dma_rx_fill(dev, q, true);
+	mt76_dma_rx_fill(dev, q);
 	return done;
 }
 
@@ -498,7 +697,7 @@ mt76_dma_init(struct mt76_dev *dev)
 	for (i = 0; i < ARRAY_SIZE(dev->q_rx); i++) {
 		netif_napi_add(&dev->napi_dev, &dev->napi[i], mt76_dma_rx_poll,
 			       64);
-		mt76_dma_rx_fill(dev, &dev->q_rx[i], false);
+		mt76_dma_rx_fill(dev, &dev->q_rx[i]);
 		skb_queue_head_init(&dev->rx_skb[i]);
 		napi_enable(&dev->napi[i]);
 	}
@@ -531,8 +730,22 @@ void mt76_dma_cleanup(struct mt76_dev *dev)
 		mt76_dma_tx_cleanup(dev, i, true);
 
 	for (i = 0; i < ARRAY_SIZE(dev->q_rx); i++) {
-		netif_napi_del(&dev->napi[i]);
-		mt76_dma_rx_cleanup(dev, &dev->q_rx[i]);
+		struct mt76_queue *q = &dev->q_rx[i];
+
+		/* init may have failed before the queues were set up */
+		if (dev->napi[i].poll)
+			netif_napi_del(&dev->napi[i]);
+
+		if (!q->ndesc)
+			continue;
+
+		mt76_dma_rx_cleanup(dev, q);
+		mt76_dma_rx_free_inflight(q);
+
+		if (q->page_pool) {
+			page_pool_destroy(q->page_pool);
+			q->page_pool = NULL;
+		}
 	}
 }
 EXPORT_SYMBOL_GPL(mt76_dma_cleanup);
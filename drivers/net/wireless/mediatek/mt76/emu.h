@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2026 The mt76 contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef __MT76_EMU_H
+#define __MT76_EMU_H
+
+#include <linux/platform_device.h>
+#include "mt76.h"
+#include "dma.h"
+
+/*
+ * Emulated device register map. The register file lives in host memory
+ * and is accessed through mt76_bus_ops, the descriptor rings use the
+ * regular mt76 DMA layout.
+ */
+#define MT_EMU_REGS_SIZE		0x1000
+
+#define MT_EMU_ASIC_VERSION		0x0000
+
+#define MT_EMU_INT_SOURCE_CSR		0x0200
+#define MT_EMU_INT_MASK_CSR		0x0204
+
+#define MT_EMU_INT_RX_DONE(_n)		BIT(_n)
+#define MT_EMU_INT_RX_DONE_ALL		GENMASK(1, 0)
+#define MT_EMU_INT_TX_DONE		BIT(4)
+
+#define MT_EMU_TX_RING_BASE		0x0400
+#define MT_EMU_RX_RING_BASE		0x0800
+
+#define MT_EMU_TX_HW_QUEUE_MGMT		4
+#define MT_EMU_TX_HW_QUEUES		5
+
+#define MT_EMU_RX_RING_SIZE		128
+#define MT_EMU_RX_HEADROOM		32
+
+#define MT_EMU_N_WCIDS			128
+#define MT_EMU_VIF_WCID(_n)		(MT_EMU_N_WCIDS - 1 - (_n))
+
+/* frames processed by a single firmware run before yielding */
+#define MT_EMU_FW_BUDGET		64
+
+#define MT_EMU_TXWI_FLAG_AMPDU		BIT(0)
+#define MT_EMU_TXWI_FLAG_NO_ACK		BIT(1)
+
+struct mt76_emu_txwi {
+	__le16 len;
+	u8 wcid;
+	u8 flags;
+	__le16 rate;
+	__le16 rsv;
+} __packed __aligned(4);
+
+#define MT_EMU_RXWI_FLAG_AMPDU		BIT(0)
+
+#define MT_EMU_RXWI_TID			GENMASK(3, 0)
+#define MT_EMU_RXWI_SN			GENMASK(15, 4)
+
+struct mt76_emu_rxwi {
+	__le16 len;
+	u8 wcid;
+	u8 flags;
+	__le16 tid_sn;
+	__le16 rate;
+} __packed __aligned(4);
+
+struct mt76_emu_stats {
+	u32 fw_runs;
+	u32 tx_frames;
+	u32 tx_bytes;
+	u32 tx_errors;
+	u32 rx_frames;
+	u32 rx_bytes;
+	u32 rx_no_buf;
+	u32 irqs;
+};
+
+struct mt76_emu_vif {
+	u8 idx;
+
+	struct mt76_wcid group_wcid;
+};
+
+struct mt76_emu_sta {
+	struct mt76_wcid wcid; /* must be first */
+
+	struct mt76_emu_vif *vif;
+};
+
+struct mt76_emu_dev {
+	struct mt76_dev mt76; /* must be first */
+
+	struct mutex mutex;
+
+	spinlock_t irq_lock;
+	u32 irqmask;
+
+	/* serializes firmware access to the register file */
+	spinlock_t reg_lock;
+
+	const struct mt76_queue_ops *dma_ops;
+	struct mt76_queue_ops queue_ops;
+
+	struct tasklet_struct fw_tasklet;
+	struct tasklet_struct tx_tasklet;
+
+	unsigned long wcid_mask[MT_EMU_N_WCIDS / BITS_PER_LONG];
+	unsigned long vif_mask;
+
+	struct mt76_wcid global_wcid;
+	struct mt76_wcid __rcu *wcid[MT_EMU_N_WCIDS];
+
+	struct mt76_emu_stats stats;
+};
+
+extern const struct ieee80211_ops mt76_emu_ops;
+
+struct mt76_emu_dev *mt76_emu_alloc_device(struct device *pdev);
+int mt76_emu_register_device(struct mt76_emu_dev *dev);
+void mt76_emu_cleanup(struct mt76_emu_dev *dev);
+
+void mt76_emu_set_irq_mask(struct mt76_emu_dev *dev, u32 clear, u32 set);
+
+static inline void mt76_emu_irq_enable(struct mt76_emu_dev *dev, u32 mask)
+{
+	mt76_emu_set_irq_mask(dev, 0, mask);
+}
+
+static inline void mt76_emu_irq_disable(struct mt76_emu_dev *dev, u32 mask)
+{
+	mt76_emu_set_irq_mask(dev, mask, 0);
+}
+
+void mt76_emu_irq_handler(struct mt76_emu_dev *dev);
+
+int mt76_emu_tx_prepare_skb(struct mt76_dev *mdev, void *txwi,
+			    struct sk_buff *skb, struct mt76_queue *q,
+			    struct mt76_wcid *wcid, struct ieee80211_sta *sta,
+			    u32 *tx_info);
+void mt76_emu_tx_complete_skb(struct mt76_dev *mdev, struct mt76_queue *q,
+			      struct mt76_queue_entry *e, bool flush);
+void mt76_emu_queue_rx_skb(struct mt76_dev *mdev, enum mt76_rxq_id q,
+			   struct sk_buff *skb);
+void mt76_emu_rx_poll_complete(struct mt76_dev *mdev, enum mt76_rxq_id q);
+void mt76_emu_sta_ps(struct mt76_dev *mdev, struct ieee80211_sta *sta,
+		     bool ps);
+
+int mt76_emu_dma_setup(struct device *dev);
+void *mt76_emu_dma_ptr(u32 addr, size_t len);
+
+void mt76_emu_fw_init(struct mt76_emu_dev *dev);
+void mt76_emu_fw_stop(struct mt76_emu_dev *dev);
+void mt76_emu_fw_kick(struct mt76_emu_dev *dev);
+void mt76_emu_fw_update_irq(struct mt76_emu_dev *dev);
+
+#endif
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2026 The mt76 contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Bus address space of the emulated device. Every buffer mt76 maps for
+ * the device gets a 32 bit bus address that only means something to the
+ * emulated firmware, which uses it to look the CPU pointer back up. This
+ * works the same whatever the amount of RAM and whether the system uses
+ * an IOMMU or bounce buffers, and mapped buffers are never copied.
+ *
+ * A bus address is made of a mapping id in the upper 16 bits and the
+ * offset into the mapping in the lower 16 bits, so a single mapping can
+ * not be larger than 64k. Id 0 is never handed out, which makes 0 the
+ * error cookie.
+ */
+
+#include <linux/dma-mapping.h>
+#include <linux/idr.h>
+#include <linux/slab.h>
+#include "emu.h"
+
+#define MT_EMU_DMA_SHIFT	16
+#define MT_EMU_DMA_MAX_LEN	BIT(MT_EMU_DMA_SHIFT)
+#define MT_EMU_DMA_MAX_ID	BIT(32 - MT_EMU_DMA_SHIFT)
+
+struct mt76_emu_dma_map {
+	void *ptr;
+	size_t len;
+};
+
+static DEFINE_IDR(mt76_emu_dma_idr);
+static DEFINE_SPINLOCK(mt76_emu_dma_lock);
+
+static dma_addr_t mt76_emu_dma_map(void *ptr, size_t len, gfp_t gfp)
+{
+	struct mt76_emu_dma_map *map;
+	unsigned long flags;
+	int id;
+
+	if (!ptr || WARN_ON_ONCE(!len || len > MT_EMU_DMA_MAX_LEN))
+		return 0;
+
+	map = kmalloc(sizeof(*map), gfp);
+	if (!map)
+		return 0;
+
+	map->ptr = ptr;
+	map->len = len;
+
+	/* cyclic ids make stale bus addresses fail the lookup */
+	spin_lock_irqsave(&mt76_emu_dma_lock, flags);
+	id = idr_alloc_cyclic(&mt76_emu_dma_idr, map, 1, MT_EMU_DMA_MAX_ID,
+			      GFP_ATOMIC);
+	spin_unlock_irqrestore(&mt76_emu_dma_lock, flags);
+
+	if (id < 0) {
+		kfree(map);
+		return 0;
+	}
+
+	return (dma_addr_t)id << MT_EMU_DMA_SHIFT;
+}
+
+static void mt76_emu_dma_unmap(dma_addr_t addr)
+{
+	struct mt76_emu_dma_map *map;
+	unsigned long flags;
+
+	spin_lock_irqsave(&mt76_emu_dma_lock, flags);
+	map = idr_remove(&mt76_emu_dma_idr, addr >> MT_EMU_DMA_SHIFT);
+	spin_unlock_irqrestore(&mt76_emu_dma_lock, flags);
+
+	WARN_ON_ONCE(!map);
+	kfree(map);
+}
+
+/*
+ * Return the CPU pointer for len bytes at bus address addr, or NULL if
+ * the range is not covered by a single mapping.
+ */
+void *mt76_emu_dma_ptr(u32 addr, size_t len)
+{
+	u32 offset = addr & (MT_EMU_DMA_MAX_LEN - 1);
+	struct mt76_emu_dma_map *map;
+	unsigned long flags;
+	void *ptr = NULL;
+
+	spin_lock_irqsave(&mt76_emu_dma_lock, flags);
+	map = idr_find(&mt76_emu_dma_idr, addr >> MT_EMU_DMA_SHIFT);
+	if (map && offset + len <= map->len)
+		ptr = map->ptr + offset;
+	spin_unlock_irqrestore(&mt76_emu_dma_lock, flags);
+
+	return ptr;
+}
+
+static void *
+mt76_emu_dma_alloc(struct device *dev, size_t size, dma_addr_t *dma_handle,
+		   gfp_t gfp, unsigned long attrs)
+{
+	void *ptr;
+
+	ptr = alloc_pages_exact(size, gfp | __GFP_ZERO);
+	if (!ptr)
+		return NULL;
+
+	*dma_handle = mt76_emu_dma_map(ptr, size, gfp);
+	if (!*dma_handle) {
+		free_pages_exact(ptr, size);
+		return NULL;
+	}
+
+	return ptr;
+}
+
+static void
+mt76_emu_dma_free(struct device *dev, size_t size, void *ptr,
+		  dma_addr_t dma_handle, unsigned long attrs)
+{
+	mt76_emu_dma_unmap(dma_handle);
+	free_pages_exact(ptr, size);
+}
+
+static dma_addr_t
+mt76_emu_dma_map_page(struct device *dev, struct page *page,
+		      unsigned long offset, size_t size,
+		      enum dma_data_direction dir, unsigned long attrs)
+{
+	void *ptr = page_address(page);
+
+	/* the emulated engine can only reach memory with a kernel mapping */
+	if (!ptr)
+		return 0;
+
+	return mt76_emu_dma_map(ptr + offset, size, GFP_ATOMIC);
+}
+
+static void
+mt76_emu_dma_unmap_page(struct device *dev, dma_addr_t dma_handle,
+			size_t size, enum dma_data_direction dir,
+			unsigned long attrs)
+{
+	mt76_emu_dma_unmap(dma_handle);
+}
+
+static int mt76_emu_dma_mapping_error(struct device *dev, dma_addr_t addr)
+{
+	return !addr;
+}
+
+static int mt76_emu_dma_supported(struct device *dev, u64 mask)
+{
+	return mask >= DMA_BIT_MASK(32);
+}
+
+/*
+ * The firmware works on the buffers themselves, so there is nothing to
+ * sync and the sync callbacks are left out.
+ */
+static const struct dma_map_ops mt76_emu_dma_ops = {
+	.alloc = mt76_emu_dma_alloc,
+	.free = mt76_emu_dma_free,
+	.map_page = mt76_emu_dma_map_page,
+	.unmap_page = mt76_emu_dma_unmap_page,
+	.mapping_error = mt76_emu_dma_mapping_error,
+	.dma_supported = mt76_emu_dma_supported,
+};
+
+int mt76_emu_dma_setup(struct device *dev)
+{
+	set_dma_ops(dev, &mt76_emu_dma_ops);
+
+	return dma_coerce_mask_and_coherent(dev, DMA_BIT_MASK(32));
+}
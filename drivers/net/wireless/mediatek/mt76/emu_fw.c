@@ -0,0 +1,360 @@
+/*
+ * Copyright (C) 2026 The mt76 contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Software "firmware" for the emulated device. It only looks at the
+ * register file and at the descriptor rings the host has programmed into
+ * it, just like the DMA engine of a real chip would: every frame queued
+ * on a tx ring is looped back into the main rx ring as if the peer had
+ * sent it back, and completed. Bus addresses are resolved through the
+ * emulated address space, see emu_dma.c.
+ */
+
+#include "emu.h"
+
+/* 32 buffers per frame at most, see mt76_dma_tx_queue_skb */
+#define MT_EMU_FW_MAX_SEGS	32
+
+struct mt76_emu_ring {
+	struct mt76_queue_regs __iomem *regs;
+	struct mt76_desc *desc;
+	u32 ndesc;
+	u32 cpu_idx;
+	u32 dma_idx;
+};
+
+struct mt76_emu_seg {
+	void *data;
+	int len;
+};
+
+static bool
+mt76_emu_fw_ring_load(struct mt76_emu_dev *dev, struct mt76_emu_ring *ring,
+		      u32 base)
+{
+	ring->regs = dev->mt76.regs + base;
+	ring->ndesc = ioread32(&ring->regs->ring_size);
+	if (!ring->ndesc)
+		return false;
+
+	ring->desc = mt76_emu_dma_ptr(ioread32(&ring->regs->desc_base),
+				      ring->ndesc * sizeof(*ring->desc));
+	if (!ring->desc)
+		return false;
+
+	ring->cpu_idx = ioread32(&ring->regs->cpu_idx);
+	ring->dma_idx = ioread32(&ring->regs->dma_idx);
+
+	/* pairs with the descriptor writes preceding the queue kick */
+	rmb();
+
+	return ring->cpu_idx < ring->ndesc && ring->dma_idx < ring->ndesc;
+}
+
+static int
+mt76_emu_fw_rx_space(struct mt76_emu_ring *rx, int len)
+{
+	u32 idx = rx->dma_idx;
+	int n = 0;
+
+	while (len > 0) {
+		u32 ctrl, size;
+
+		if (idx == rx->cpu_idx)
+			return -ENOSPC;
+
+		ctrl = le32_to_cpu(READ_ONCE(rx->desc[idx].ctrl));
+		size = FIELD_GET(MT_DMA_CTL_SD_LEN0, ctrl);
+		if (!mt76_emu_dma_ptr(le32_to_cpu(rx->desc[idx].buf0), size))
+			return -EFAULT;
+
+		len -= size;
+		idx = (idx + 1) % rx->ndesc;
+		n++;
+	}
+
+	return n;
+}
+
+/*
+ * Turn a copy of the header into the one the peer would send back:
+ * swap the receiver and transmitter address and flip the DS bits, so
+ * that mac80211 takes the frame as received from the station it was
+ * sent to, with the wcid the frame was sent with. Group addressed and
+ * short control frames have no such peer and are left alone.
+ */
+static void
+mt76_emu_fw_mirror_hdr(struct ieee80211_hdr *hdr, int len)
+{
+	__le16 fc = hdr->frame_control;
+	int hdrlen = ieee80211_hdrlen(fc);
+	u8 addr[ETH_ALEN];
+
+	if (len < hdrlen || hdrlen < offsetof(struct ieee80211_hdr, addr3) ||
+	    is_multicast_ether_addr(hdr->addr1))
+		return;
+
+	ether_addr_copy(addr, hdr->addr1);
+	ether_addr_copy(hdr->addr1, hdr->addr2);
+	ether_addr_copy(hdr->addr2, addr);
+
+	if (ieee80211_has_a4(fc)) {
+		ether_addr_copy(addr, hdr->addr3);
+		ether_addr_copy(hdr->addr3, hdr->addr4);
+		ether_addr_copy(hdr->addr4, addr);
+	} else if (ieee80211_has_tods(fc) || ieee80211_has_fromds(fc)) {
+		hdr->frame_control ^= cpu_to_le16(IEEE80211_FCTL_TODS |
+						  IEEE80211_FCTL_FROMDS);
+	}
+}
+
+static void
+mt76_emu_fw_rx_frame(struct mt76_emu_dev *dev, struct mt76_emu_ring *rx,
+		     struct mt76_emu_txwi *txwi, struct mt76_emu_seg *seg,
+		     int nseg, int len)
+{
+	struct mt76_emu_seg src[MT_EMU_FW_MAX_SEGS + 2];
+	struct ieee80211_hdr *hdr = seg[0].data;
+	struct mt76_emu_rxwi rxwi = {};
+	struct ieee80211_hdr mhdr;
+	int i, ndesc, nsrc = 0, cur = 0;
+	int hdrlen;
+
+	ndesc = mt76_emu_fw_rx_space(rx, len + sizeof(rxwi));
+	if (ndesc < 0) {
+		/* the host queued a buffer it did not map */
+		WARN_ON_ONCE(ndesc == -EFAULT);
+		dev->stats.rx_no_buf++;
+		return;
+	}
+
+	rxwi.len = cpu_to_le16(len);
+	rxwi.wcid = txwi->wcid;
+	rxwi.rate = txwi->rate;
+	if (txwi->flags & MT_EMU_TXWI_FLAG_AMPDU)
+		rxwi.flags |= MT_EMU_RXWI_FLAG_AMPDU;
+
+	if (seg[0].len >= sizeof(*hdr) &&
+	    ieee80211_is_data_qos(hdr->frame_control)) {
+		u8 tid = *ieee80211_get_qos_ctl(hdr) &
+			 IEEE80211_QOS_CTL_TID_MASK;
+		u16 sn = IEEE80211_SEQ_TO_SN(le16_to_cpu(hdr->seq_ctrl));
+
+		rxwi.tid_sn = cpu_to_le16(FIELD_PREP(MT_EMU_RXWI_TID, tid) |
+					  FIELD_PREP(MT_EMU_RXWI_SN, sn));
+	}
+
+	/* the tx buffers belong to the host, mirror the header in a copy */
+	hdrlen = min_t(int, seg[0].len, sizeof(mhdr));
+	memcpy(&mhdr, hdr, hdrlen);
+	mt76_emu_fw_mirror_hdr(&mhdr, seg[0].len);
+
+	src[nsrc].data = &rxwi;
+	src[nsrc++].len = sizeof(rxwi);
+	src[nsrc].data = &mhdr;
+	src[nsrc++].len = hdrlen;
+	src[nsrc].data = seg[0].data + hdrlen;
+	src[nsrc++].len = seg[0].len - hdrlen;
+	for (i = 1; i < nseg; i++)
+		src[nsrc++] = seg[i];
+
+	for (i = 0; i < ndesc; i++) {
+		struct mt76_desc *desc = &rx->desc[rx->dma_idx];
+		u32 ctrl = le32_to_cpu(READ_ONCE(desc->ctrl));
+		int size = FIELD_GET(MT_DMA_CTL_SD_LEN0, ctrl);
+		u8 *dest = mt76_emu_dma_ptr(le32_to_cpu(desc->buf0), size);
+		int used = 0;
+
+		while (used < size && cur < nsrc) {
+			int n = min(size - used, src[cur].len);
+
+			memcpy(dest + used, src[cur].data, n);
+			used += n;
+			src[cur].data += n;
+			src[cur].len -= n;
+
+			if (!src[cur].len)
+				cur++;
+		}
+
+		ctrl = FIELD_PREP(MT_DMA_CTL_SD_LEN0, used) |
+		       MT_DMA_CTL_DMA_DONE;
+		if (i == ndesc - 1)
+			ctrl |= MT_DMA_CTL_LAST_SEC0;
+
+		/* make the payload visible before handing the buffer back */
+		wmb();
+		WRITE_ONCE(desc->ctrl, cpu_to_le32(ctrl));
+
+		rx->dma_idx = (rx->dma_idx + 1) % rx->ndesc;
+	}
+
+	iowrite32(rx->dma_idx, &rx->regs->dma_idx);
+
+	dev->stats.rx_frames++;
+	dev->stats.rx_bytes += len;
+}
+
+static void
+mt76_emu_fw_tx_frame(struct mt76_emu_dev *dev, struct mt76_emu_ring *tx,
+		     struct mt76_emu_ring *rx)
+{
+	struct mt76_emu_seg seg[MT_EMU_FW_MAX_SEGS];
+	struct mt76_emu_txwi *txwi;
+	u32 idx = tx->dma_idx;
+	int i, nseg = 0, len = 0;
+	bool bad = false;
+	u32 ctrl;
+
+	/*
+	 * Malformed chains (too long, not closed before cpu_idx, or with
+	 * buffers that are not mapped for the device) are consumed without
+	 * being looped back, so that the ring keeps moving.
+	 */
+	do {
+		struct mt76_desc *desc;
+
+		if (idx == tx->cpu_idx) {
+			bad = true;
+			break;
+		}
+
+		desc = &tx->desc[idx];
+		ctrl = le32_to_cpu(READ_ONCE(desc->ctrl));
+		idx = (idx + 1) % tx->ndesc;
+
+		if (nseg + 2 > ARRAY_SIZE(seg)) {
+			bad = true;
+			continue;
+		}
+
+		seg[nseg].len = FIELD_GET(MT_DMA_CTL_SD_LEN0, ctrl);
+		seg[nseg].data = mt76_emu_dma_ptr(le32_to_cpu(desc->buf0),
+						  seg[nseg].len);
+		if (!seg[nseg++].data)
+			bad = true;
+
+		if (!(ctrl & MT_DMA_CTL_LAST_SEC0)) {
+			seg[nseg].len = FIELD_GET(MT_DMA_CTL_SD_LEN1, ctrl);
+			seg[nseg].data =
+				mt76_emu_dma_ptr(le32_to_cpu(desc->buf1),
+						 seg[nseg].len);
+			if (!seg[nseg++].data)
+				bad = true;
+		}
+	} while (!(ctrl & (MT_DMA_CTL_LAST_SEC0 | MT_DMA_CTL_LAST_SEC1)));
+
+	tx->dma_idx = idx;
+
+	/* the first buffer always holds the txwi */
+	if (bad || nseg < 2 || seg[0].len != sizeof(*txwi)) {
+		dev->stats.tx_errors++;
+		return;
+	}
+
+	txwi = seg[0].data;
+	for (i = 1; i < nseg; i++)
+		len += seg[i].len;
+
+	dev->stats.tx_frames++;
+	dev->stats.tx_bytes += len;
+
+	if (rx)
+		mt76_emu_fw_rx_frame(dev, rx, txwi, &seg[1], nseg - 1, len);
+}
+
+static u32
+mt76_emu_fw_raise_irq(struct mt76_emu_dev *dev, u32 intr)
+{
+	unsigned long flags;
+	u32 val;
+
+	spin_lock_irqsave(&dev->reg_lock, flags);
+	val = ioread32(dev->mt76.regs + MT_EMU_INT_SOURCE_CSR) | intr;
+	iowrite32(val, dev->mt76.regs + MT_EMU_INT_SOURCE_CSR);
+	val &= ioread32(dev->mt76.regs + MT_EMU_INT_MASK_CSR);
+	spin_unlock_irqrestore(&dev->reg_lock, flags);
+
+	return val;
+}
+
+static void
+mt76_emu_fw_tasklet(unsigned long data)
+{
+	struct mt76_emu_dev *dev = (struct mt76_emu_dev *) data;
+	struct mt76_emu_ring rx_ring, tx_ring;
+	struct mt76_emu_ring *rx = &rx_ring;
+	int budget = MT_EMU_FW_BUDGET;
+	u32 intr = 0;
+	int i;
+
+	dev->stats.fw_runs++;
+
+	if (!mt76_emu_fw_ring_load(dev, rx, MT_EMU_RX_RING_BASE))
+		rx = NULL;
+
+	for (i = 0; i < MT_EMU_TX_HW_QUEUES; i++) {
+		u32 base = MT_EMU_TX_RING_BASE + i * MT_RING_SIZE;
+		struct mt76_emu_ring *tx = &tx_ring;
+		u32 rx_done = rx ? rx->dma_idx : 0;
+
+		if (!mt76_emu_fw_ring_load(dev, tx, base))
+			continue;
+
+		while (tx->dma_idx != tx->cpu_idx && budget > 0) {
+			mt76_emu_fw_tx_frame(dev, tx, rx);
+			iowrite32(tx->dma_idx, &tx->regs->dma_idx);
+			intr |= MT_EMU_INT_TX_DONE;
+			budget--;
+		}
+
+		if (rx && rx->dma_idx != rx_done)
+			intr |= MT_EMU_INT_RX_DONE(0);
+	}
+
+	if (!budget)
+		tasklet_schedule(&dev->fw_tasklet);
+
+	if (mt76_emu_fw_raise_irq(dev, intr))
+		mt76_emu_irq_handler(dev);
+}
+
+void mt76_emu_fw_update_irq(struct mt76_emu_dev *dev)
+{
+	u32 intr;
+
+	intr = ioread32(dev->mt76.regs + MT_EMU_INT_SOURCE_CSR);
+	intr &= ioread32(dev->mt76.regs + MT_EMU_INT_MASK_CSR);
+	if (intr)
+		tasklet_schedule(&dev->fw_tasklet);
+}
+
+void mt76_emu_fw_kick(struct mt76_emu_dev *dev)
+{
+	tasklet_schedule(&dev->fw_tasklet);
+}
+
+void mt76_emu_fw_init(struct mt76_emu_dev *dev)
+{
+	tasklet_init(&dev->fw_tasklet, mt76_emu_fw_tasklet,
+		     (unsigned long) dev);
+	iowrite32(0x76ee0001, dev->mt76.regs + MT_EMU_ASIC_VERSION);
+}
+
+void mt76_emu_fw_stop(struct mt76_emu_dev *dev)
+{
+	tasklet_kill(&dev->fw_tasklet);
+}
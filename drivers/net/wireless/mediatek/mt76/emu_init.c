@@ -0,0 +1,431 @@
+/*
+ * Copyright (C) 2026 The mt76 contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/debugfs.h>
+#include <linux/dma-mapping.h>
+#include <linux/etherdevice.h>
+
+#include "emu.h"
+
+#define CCK_RATE(_idx, _rate) {					\
+	.bitrate = _rate,					\
+	.flags = IEEE80211_RATE_SHORT_PREAMBLE,			\
+	.hw_value = (MT_PHY_TYPE_CCK << 8) | _idx,		\
+	.hw_value_short = (MT_PHY_TYPE_CCK << 8) | (8 + _idx),	\
+}
+
+#define OFDM_RATE(_idx, _rate) {				\
+	.bitrate = _rate,					\
+	.hw_value = (MT_PHY_TYPE_OFDM << 8) | _idx,		\
+	.hw_value_short = (MT_PHY_TYPE_OFDM << 8) | _idx,	\
+}
+
+static struct ieee80211_rate mt76_emu_rates[] = {
+	CCK_RATE(0, 10),
+	CCK_RATE(1, 20),
+	CCK_RATE(2, 55),
+	CCK_RATE(3, 110),
+	OFDM_RATE(0, 60),
+	OFDM_RATE(1, 90),
+	OFDM_RATE(2, 120),
+	OFDM_RATE(3, 180),
+	OFDM_RATE(4, 240),
+	OFDM_RATE(5, 360),
+	OFDM_RATE(6, 480),
+	OFDM_RATE(7, 540),
+};
+
+static const struct ieee80211_iface_limit if_limits[] = {
+	{
+		.max = 1,
+		.types = BIT(NL80211_IFTYPE_ADHOC)
+	}, {
+		.max = 8,
+		.types = BIT(NL80211_IFTYPE_STATION) |
+#ifdef CONFIG_MAC80211_MESH
+			 BIT(NL80211_IFTYPE_MESH_POINT) |
+#endif
+			 BIT(NL80211_IFTYPE_AP)
+	 },
+};
+
+static const struct ieee80211_iface_combination if_comb[] = {
+	{
+		.limits = if_limits,
+		.n_limits = ARRAY_SIZE(if_limits),
+		.max_interfaces = 8,
+		.num_different_channels = 1,
+		.beacon_int_infra_match = true,
+	}
+};
+
+static u32 mt76_emu_rr(struct mt76_dev *mdev, u32 offset)
+{
+	if (WARN_ON_ONCE(offset >= MT_EMU_REGS_SIZE))
+		return ~0;
+
+	return ioread32(mdev->regs + offset);
+}
+
+static void mt76_emu_wr(struct mt76_dev *mdev, u32 offset, u32 val)
+{
+	struct mt76_emu_dev *dev = container_of(mdev, struct mt76_emu_dev, mt76);
+	unsigned long flags;
+
+	if (WARN_ON_ONCE(offset >= MT_EMU_REGS_SIZE))
+		return;
+
+	spin_lock_irqsave(&dev->reg_lock, flags);
+
+	/* interrupt status bits are write-1-to-clear */
+	if (offset == MT_EMU_INT_SOURCE_CSR)
+		val = ioread32(mdev->regs + offset) & ~val;
+
+	iowrite32(val, mdev->regs + offset);
+	spin_unlock_irqrestore(&dev->reg_lock, flags);
+
+	if (offset == MT_EMU_INT_MASK_CSR)
+		mt76_emu_fw_update_irq(dev);
+}
+
+static u32 mt76_emu_rmw(struct mt76_dev *mdev, u32 offset, u32 mask, u32 val)
+{
+	val |= mt76_emu_rr(mdev, offset) & ~mask;
+	mt76_emu_wr(mdev, offset, val);
+	return val;
+}
+
+static void mt76_emu_copy(struct mt76_dev *mdev, u32 offset, const void *data,
+			  int len)
+{
+	if (WARN_ON_ONCE(offset + len > MT_EMU_REGS_SIZE))
+		return;
+
+	__iowrite32_copy(mdev->regs + offset, data, len >> 2);
+}
+
+static void mt76_emu_bus_init(struct mt76_emu_dev *dev, void __iomem *regs)
+{
+	static const struct mt76_bus_ops mt76_emu_bus_ops = {
+		.rr = mt76_emu_rr,
+		.rmw = mt76_emu_rmw,
+		.wr = mt76_emu_wr,
+		.copy = mt76_emu_copy,
+	};
+
+	dev->mt76.bus = &mt76_emu_bus_ops;
+	dev->mt76.regs = regs;
+}
+
+static void
+mt76_emu_kick_queue(struct mt76_dev *mdev, struct mt76_queue *q)
+{
+	struct mt76_emu_dev *dev = container_of(mdev, struct mt76_emu_dev, mt76);
+
+	dev->dma_ops->kick(mdev, q);
+	mt76_emu_fw_kick(dev);
+}
+
+static int
+mt76_emu_init_tx_queue(struct mt76_emu_dev *dev, struct mt76_queue *q,
+		       int idx, int n_desc)
+{
+	q->regs = dev->mt76.regs + MT_EMU_TX_RING_BASE + idx * MT_RING_SIZE;
+	q->ndesc = n_desc;
+	q->hw_idx = idx;
+
+	return mt76_queue_alloc(dev, q);
+}
+
+static int
+mt76_emu_init_rx_queue(struct mt76_emu_dev *dev, struct mt76_queue *q,
+		       int idx, int n_desc, int bufsize)
+{
+	q->regs = dev->mt76.regs + MT_EMU_RX_RING_BASE + idx * MT_RING_SIZE;
+	q->ndesc = n_desc;
+	q->buf_size = bufsize;
+
+	return mt76_queue_alloc(dev, q);
+}
+
+static void
+mt76_emu_tx_tasklet(unsigned long data)
+{
+	struct mt76_emu_dev *dev = (struct mt76_emu_dev *) data;
+	int i;
+
+	for (i = MT_TXQ_PSD; i >= 0; i--)
+		mt76_queue_tx_cleanup(dev, i, false);
+
+	mt76_emu_irq_enable(dev, MT_EMU_INT_TX_DONE);
+}
+
+static int mt76_emu_dma_init(struct mt76_emu_dev *dev)
+{
+	static const u8 wmm_queue_map[] = {
+		[IEEE80211_AC_BE] = 0,
+		[IEEE80211_AC_BK] = 1,
+		[IEEE80211_AC_VI] = 2,
+		[IEEE80211_AC_VO] = 3,
+	};
+	struct mt76_txwi_cache __maybe_unused *t;
+	struct mt76_queue *q;
+	int i, ret;
+
+	BUILD_BUG_ON(sizeof(t->txwi) < sizeof(struct mt76_emu_txwi));
+	BUILD_BUG_ON(sizeof(struct mt76_emu_rxwi) > MT_EMU_RX_HEADROOM);
+
+	mt76_dma_attach(&dev->mt76);
+
+	/* hook queue kicks to notify the emulated firmware */
+	dev->dma_ops = dev->mt76.queue_ops;
+	dev->queue_ops = *dev->dma_ops;
+	dev->queue_ops.kick = mt76_emu_kick_queue;
+	dev->mt76.queue_ops = &dev->queue_ops;
+
+	tasklet_init(&dev->tx_tasklet, mt76_emu_tx_tasklet, (unsigned long) dev);
+
+	for (i = 0; i < ARRAY_SIZE(wmm_queue_map); i++) {
+		ret = mt76_emu_init_tx_queue(dev, &dev->mt76.q_tx[i],
+					     wmm_queue_map[i], MT_TX_RING_SIZE);
+		if (ret)
+			return ret;
+	}
+
+	ret = mt76_emu_init_tx_queue(dev, &dev->mt76.q_tx[MT_TXQ_PSD],
+				     MT_EMU_TX_HW_QUEUE_MGMT, MT_TX_RING_SIZE);
+	if (ret)
+		return ret;
+
+	ret = mt76_emu_init_rx_queue(dev, &dev->mt76.q_rx[MT_RXQ_MCU], 1,
+				     MT_MCU_RING_SIZE, MT_RX_BUF_SIZE);
+	if (ret)
+		return ret;
+
+	q = &dev->mt76.q_rx[MT_RXQ_MAIN];
+	q->buf_offset = MT_EMU_RX_HEADROOM - sizeof(struct mt76_emu_rxwi);
+	ret = mt76_emu_init_rx_queue(dev, q, 0, MT_EMU_RX_RING_SIZE,
+				     MT_RX_BUF_SIZE);
+	if (ret)
+		return ret;
+
+	return mt76_init_queues(dev);
+}
+
+void mt76_emu_cleanup(struct mt76_emu_dev *dev)
+{
+	mt76_emu_irq_disable(dev, ~0);
+	mt76_emu_fw_stop(dev);
+	tasklet_kill(&dev->tx_tasklet);
+	mt76_dma_cleanup(&dev->mt76);
+}
+
+struct mt76_emu_dev *mt76_emu_alloc_device(struct device *pdev)
+{
+	static const struct mt76_driver_ops drv_ops = {
+		.txwi_size = sizeof(struct mt76_emu_txwi),
+		.tx_prepare_skb = mt76_emu_tx_prepare_skb,
+		.tx_complete_skb = mt76_emu_tx_complete_skb,
+		.rx_skb = mt76_emu_queue_rx_skb,
+		.rx_poll_complete = mt76_emu_rx_poll_complete,
+		.sta_ps = mt76_emu_sta_ps,
+	};
+	struct mt76_emu_dev *dev;
+	struct mt76_dev *mdev;
+
+	mdev = mt76_alloc_device(sizeof(*dev), &mt76_emu_ops);
+	if (!mdev)
+		return NULL;
+
+	dev = container_of(mdev, struct mt76_emu_dev, mt76);
+	mdev->dev = pdev;
+	mdev->drv = &drv_ops;
+	mutex_init(&dev->mutex);
+	spin_lock_init(&dev->irq_lock);
+	spin_lock_init(&dev->reg_lock);
+
+	return dev;
+}
+
+static int
+mt76_emu_stats_read(struct seq_file *s, void *data)
+{
+	struct mt76_emu_dev *dev = dev_get_drvdata(s->private);
+	struct mt76_emu_stats *stats = &dev->stats;
+
+	seq_printf(s, "fw_runs=%u irqs=%u\n", stats->fw_runs, stats->irqs);
+	seq_printf(s, "tx_frames=%u tx_bytes=%u tx_errors=%u\n",
+		   stats->tx_frames, stats->tx_bytes, stats->tx_errors);
+	seq_printf(s, "rx_frames=%u rx_bytes=%u rx_no_buf=%u\n",
+		   stats->rx_frames, stats->rx_bytes, stats->rx_no_buf);
+
+	return 0;
+}
+
+static void mt76_emu_init_device(struct mt76_emu_dev *dev)
+{
+	struct ieee80211_hw *hw = mt76_hw(dev);
+	struct wiphy *wiphy = hw->wiphy;
+
+	hw->queues = 4;
+	hw->max_rates = 1;
+	hw->max_report_rates = 7;
+	hw->max_rate_tries = 1;
+
+	hw->sta_data_size = sizeof(struct mt76_emu_sta);
+	hw->vif_data_size = sizeof(struct mt76_emu_vif);
+
+	ieee80211_hw_set(hw, SUPPORTS_HT_CCK_RATES);
+	ieee80211_hw_set(hw, SUPPORTS_REORDERING_BUFFER);
+
+	wiphy->iface_combinations = if_comb;
+	wiphy->n_iface_combinations = ARRAY_SIZE(if_comb);
+	wiphy->interface_modes =
+		BIT(NL80211_IFTYPE_STATION) |
+		BIT(NL80211_IFTYPE_AP) |
+#ifdef CONFIG_MAC80211_MESH
+		BIT(NL80211_IFTYPE_MESH_POINT) |
+#endif
+		BIT(NL80211_IFTYPE_ADHOC) |
+		BIT(NL80211_IFTYPE_MONITOR);
+
+	dev->global_wcid.idx = 255;
+	dev->global_wcid.hw_key_idx = -1;
+
+	dev->mt76.cap.has_2ghz = true;
+	dev->mt76.cap.has_5ghz = true;
+	dev->mt76.antenna_mask = 3;
+	eth_random_addr(dev->mt76.macaddr);
+}
+
+int mt76_emu_register_device(struct mt76_emu_dev *dev)
+{
+	struct dentry *debugfs;
+	int ret;
+
+	mt76_emu_init_device(dev);
+	mt76_emu_fw_init(dev);
+
+	dev->mt76.rev = mt76_rr(dev, MT_EMU_ASIC_VERSION);
+	dev_info(dev->mt76.dev, "ASIC revision: %08x\n", dev->mt76.rev);
+
+	ret = mt76_emu_dma_init(dev);
+	if (ret)
+		goto fail;
+
+	set_bit(MT76_STATE_INITIALIZED, &dev->mt76.state);
+
+	ret = mt76_register_device(&dev->mt76, true, mt76_emu_rates,
+				   ARRAY_SIZE(mt76_emu_rates));
+	if (ret)
+		goto fail;
+
+	debugfs = mt76_register_debugfs(&dev->mt76);
+	if (debugfs)
+		debugfs_create_devm_seqfile(dev->mt76.dev, "emu_stats",
+					    debugfs, mt76_emu_stats_read);
+
+	return 0;
+
+fail:
+	mt76_emu_cleanup(dev);
+	return ret;
+}
+
+static int mt76_emu_probe(struct platform_device *pdev)
+{
+	struct mt76_emu_dev *dev;
+	void *regs;
+	int ret;
+
+	ret = mt76_emu_dma_setup(&pdev->dev);
+	if (ret)
+		return ret;
+
+	regs = devm_kzalloc(&pdev->dev, MT_EMU_REGS_SIZE, GFP_KERNEL);
+	if (!regs)
+		return -ENOMEM;
+
+	dev = mt76_emu_alloc_device(&pdev->dev);
+	if (!dev)
+		return -ENOMEM;
+
+	mt76_emu_bus_init(dev, (void __force __iomem *) regs);
+
+	ret = mt76_emu_register_device(dev);
+	if (ret)
+		goto error;
+
+	return 0;
+
+error:
+	ieee80211_free_hw(mt76_hw(dev));
+	return ret;
+}
+
+static int mt76_emu_remove(struct platform_device *pdev)
+{
+	struct mt76_dev *mdev = platform_get_drvdata(pdev);
+	struct mt76_emu_dev *dev = container_of(mdev, struct mt76_emu_dev, mt76);
+
+	mt76_unregister_device(mdev);
+	mt76_emu_cleanup(dev);
+	ieee80211_free_hw(mdev->hw);
+
+	return 0;
+}
+
+static struct platform_driver mt76_emu_driver = {
+	.probe		= mt76_emu_probe,
+	.remove		= mt76_emu_remove,
+	.driver = {
+		.name	= KBUILD_MODNAME,
+	},
+};
+
+static struct platform_device *mt76_emu_pdev;
+
+static int __init mt76_emu_init(void)
+{
+	int ret;
+
+	ret = platform_driver_register(&mt76_emu_driver);
+	if (ret)
+		return ret;
+
+	mt76_emu_pdev = platform_device_register_simple(KBUILD_MODNAME, -1,
+							NULL, 0);
+	if (IS_ERR(mt76_emu_pdev)) {
+		platform_driver_unregister(&mt76_emu_driver);
+		return PTR_ERR(mt76_emu_pdev);
+	}
+
+	return 0;
+}
+
+static void __exit mt76_emu_exit(void)
+{
+	platform_device_unregister(mt76_emu_pdev);
+	platform_driver_unregister(&mt76_emu_driver);
+}
+
+module_init(mt76_emu_init);
+module_exit(mt76_emu_exit);
+
+MODULE_DESCRIPTION("MediaTek MT76 emulated device");
+MODULE_LICENSE("Dual BSD/GPL");
@@ -0,0 +1,454 @@
+/*
+ * Copyright (C) 2026 The mt76 contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "emu.h"
+
+void mt76_emu_set_irq_mask(struct mt76_emu_dev *dev, u32 clear, u32 set)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&dev->irq_lock, flags);
+	dev->irqmask &= ~clear;
+	dev->irqmask |= set;
+	mt76_wr(dev, MT_EMU_INT_MASK_CSR, dev->irqmask);
+	spin_unlock_irqrestore(&dev->irq_lock, flags);
+}
+
+void mt76_emu_irq_handler(struct mt76_emu_dev *dev)
+{
+	u32 intr;
+
+	intr = mt76_rr(dev, MT_EMU_INT_SOURCE_CSR);
+	mt76_wr(dev, MT_EMU_INT_SOURCE_CSR, intr);
+
+	if (!test_bit(MT76_STATE_INITIALIZED, &dev->mt76.state))
+		return;
+
+	dev->stats.irqs++;
+	intr &= dev->irqmask;
+
+	if (intr & MT_EMU_INT_TX_DONE) {
+		mt76_emu_irq_disable(dev, MT_EMU_INT_TX_DONE);
+		tasklet_schedule(&dev->tx_tasklet);
+	}
+
+	if (intr & MT_EMU_INT_RX_DONE(0)) {
+		mt76_emu_irq_disable(dev, MT_EMU_INT_RX_DONE(0));
+		napi_schedule(&dev->mt76.napi[0]);
+	}
+
+	if (intr & MT_EMU_INT_RX_DONE(1)) {
+		mt76_emu_irq_disable(dev, MT_EMU_INT_RX_DONE(1));
+		napi_schedule(&dev->mt76.napi[1]);
+	}
+}
+
+void mt76_emu_rx_poll_complete(struct mt76_dev *mdev, enum mt76_rxq_id q)
+{
+	struct mt76_emu_dev *dev = container_of(mdev, struct mt76_emu_dev, mt76);
+
+	mt76_emu_irq_enable(dev, MT_EMU_INT_RX_DONE(q));
+}
+
+int mt76_emu_tx_prepare_skb(struct mt76_dev *mdev, void *txwi_ptr,
+			    struct sk_buff *skb, struct mt76_queue *q,
+			    struct mt76_wcid *wcid, struct ieee80211_sta *sta,
+			    u32 *tx_info)
+{
+	struct ieee80211_tx_info *info = IEEE80211_SKB_CB(skb);
+	struct mt76_emu_txwi *txwi = txwi_ptr;
+	s8 rate_idx = info->control.rates[0].idx;
+
+	memset(txwi, 0, sizeof(*txwi));
+	txwi->len = cpu_to_le16(skb->len);
+	txwi->wcid = wcid ? wcid->idx : 0xff;
+	txwi->rate = cpu_to_le16(rate_idx > 0 ? rate_idx : 0);
+
+	if (info->flags & IEEE80211_TX_CTL_AMPDU)
+		txwi->flags |= MT_EMU_TXWI_FLAG_AMPDU;
+	if (info->flags & IEEE80211_TX_CTL_NO_ACK)
+		txwi->flags |= MT_EMU_TXWI_FLAG_NO_ACK;
+
+	*tx_info = MT_TXD_INFO_80211;
+
+	return 0;
+}
+
+void mt76_emu_tx_complete_skb(struct mt76_dev *mdev, struct mt76_queue *q,
+			      struct mt76_queue_entry *e, bool flush)
+{
+	struct ieee80211_tx_info *info = IEEE80211_SKB_CB(e->skb);
+	struct mt76_emu_txwi *txwi;
+
+	if (!e->txwi || flush) {
+		ieee80211_free_txskb(mdev->hw, e->skb);
+		return;
+	}
+
+	txwi = (struct mt76_emu_txwi *) &e->txwi->txwi;
+
+	/* the emulated firmware delivers every frame it has looped back */
+	ieee80211_tx_info_clear_status(info);
+	info->status.rates[0].count = 1;
+	info->status.rates[1].idx = -1;
+
+	if (txwi->flags & MT_EMU_TXWI_FLAG_AMPDU) {
+		info->flags |= IEEE80211_TX_STAT_AMPDU;
+		info->status.ampdu_len = 1;
+		info->status.ampdu_ack_len = 1;
+	}
+
+	if (!(txwi->flags & MT_EMU_TXWI_FLAG_NO_ACK))
+		info->flags |= IEEE80211_TX_STAT_ACK;
+
+	ieee80211_tx_status(mdev->hw, e->skb);
+}
+
+static struct mt76_wcid *
+mt76_emu_rx_get_wcid(struct mt76_emu_dev *dev, u8 idx)
+{
+	if (idx >= ARRAY_SIZE(dev->wcid))
+		return NULL;
+
+	return rcu_dereference(dev->wcid[idx]);
+}
+
+static int
+mt76_emu_mac_process_rx(struct mt76_emu_dev *dev, struct sk_buff *skb,
+			struct mt76_emu_rxwi *rxwi)
+{
+	struct mt76_rx_status *status = (struct mt76_rx_status *) skb->cb;
+	struct ieee80211_channel *chan = dev->mt76.chandef.chan;
+	struct ieee80211_supported_band *sband;
+	u16 tid_sn = le16_to_cpu(rxwi->tid_sn);
+	u16 rate = le16_to_cpu(rxwi->rate);
+	int len = le16_to_cpu(rxwi->len);
+
+	if (!test_bit(MT76_STATE_RUNNING, &dev->mt76.state))
+		return -EINVAL;
+
+	if (WARN_ON_ONCE(len > skb->len))
+		return -EINVAL;
+
+	pskb_trim(skb, len);
+
+	memset(status, 0, sizeof(*status));
+	status->wcid = mt76_emu_rx_get_wcid(dev, rxwi->wcid);
+	status->aggr = !!(rxwi->flags & MT_EMU_RXWI_FLAG_AMPDU);
+	status->tid = FIELD_GET(MT_EMU_RXWI_TID, tid_sn);
+	status->seqno = FIELD_GET(MT_EMU_RXWI_SN, tid_sn);
+
+	status->freq = chan->center_freq;
+	status->band = chan->band;
+	status->chains = BIT(0) | BIT(1);
+	status->chain_signal[0] = -30;
+	status->chain_signal[1] = -30;
+	status->signal = -30;
+
+	sband = dev->mt76.hw->wiphy->bands[chan->band];
+	status->encoding = RX_ENC_LEGACY;
+	status->rate_idx = rate < sband->n_bitrates ? rate : 0;
+
+	return 0;
+}
+
+void mt76_emu_queue_rx_skb(struct mt76_dev *mdev, enum mt76_rxq_id q,
+			   struct sk_buff *skb)
+{
+	struct mt76_emu_dev *dev = container_of(mdev, struct mt76_emu_dev, mt76);
+	struct mt76_emu_rxwi *rxwi = (struct mt76_emu_rxwi *) skb->data;
+
+	if (q == MT_RXQ_MCU) {
+		dev_kfree_skb(skb);
+		return;
+	}
+
+	skb_pull(skb, sizeof(*rxwi));
+	if (mt76_emu_mac_process_rx(dev, skb, rxwi)) {
+		dev_kfree_skb(skb);
+		return;
+	}
+
+	mt76_rx(mdev, q, skb);
+}
+
+void mt76_emu_sta_ps(struct mt76_dev *mdev, struct ieee80211_sta *sta,
+		     bool ps)
+{
+	mt76_stop_tx_queues(mdev, sta, true);
+}
+
+static void
+mt76_emu_tx(struct ieee80211_hw *hw, struct ieee80211_tx_control *control,
+	    struct sk_buff *skb)
+{
+	struct ieee80211_tx_info *info = IEEE80211_SKB_CB(skb);
+	struct mt76_emu_dev *dev = hw->priv;
+	struct ieee80211_vif *vif = info->control.vif;
+	struct mt76_wcid *wcid = &dev->global_wcid;
+
+	if (control->sta) {
+		struct mt76_emu_sta *msta;
+
+		msta = (struct mt76_emu_sta *) control->sta->drv_priv;
+		wcid = &msta->wcid;
+	} else if (vif) {
+		struct mt76_emu_vif *mvif;
+
+		mvif = (struct mt76_emu_vif *) vif->drv_priv;
+		wcid = &mvif->group_wcid;
+	}
+
+	mt76_tx(&dev->mt76, control->sta, wcid, skb);
+}
+
+static int
+mt76_emu_start(struct ieee80211_hw *hw)
+{
+	struct mt76_emu_dev *dev = hw->priv;
+
+	mutex_lock(&dev->mutex);
+	set_bit(MT76_STATE_RUNNING, &dev->mt76.state);
+	mt76_emu_irq_enable(dev, MT_EMU_INT_RX_DONE_ALL | MT_EMU_INT_TX_DONE);
+	mutex_unlock(&dev->mutex);
+
+	return 0;
+}
+
+static void
+mt76_emu_stop(struct ieee80211_hw *hw)
+{
+	struct mt76_emu_dev *dev = hw->priv;
+
+	mutex_lock(&dev->mutex);
+	clear_bit(MT76_STATE_RUNNING, &dev->mt76.state);
+	mt76_emu_irq_disable(dev, MT_EMU_INT_RX_DONE_ALL | MT_EMU_INT_TX_DONE);
+	mutex_unlock(&dev->mutex);
+}
+
+static int
+mt76_emu_add_interface(struct ieee80211_hw *hw, struct ieee80211_vif *vif)
+{
+	struct mt76_emu_dev *dev = hw->priv;
+	struct mt76_emu_vif *mvif = (struct mt76_emu_vif *) vif->drv_priv;
+	int ret = 0;
+	int idx;
+
+	mutex_lock(&dev->mutex);
+
+	idx = ffz(dev->vif_mask);
+	if (idx >= 8) {
+		ret = -EBUSY;
+		goto out;
+	}
+
+	dev->vif_mask |= BIT(idx);
+	mvif->idx = idx;
+	mvif->group_wcid.idx = MT_EMU_VIF_WCID(idx);
+	mvif->group_wcid.hw_key_idx = -1;
+	mt76_txq_init(&dev->mt76, vif->txq);
+
+out:
+	mutex_unlock(&dev->mutex);
+
+	return ret;
+}
+
+static void
+mt76_emu_remove_interface(struct ieee80211_hw *hw, struct ieee80211_vif *vif)
+{
+	struct mt76_emu_dev *dev = hw->priv;
+	struct mt76_emu_vif *mvif = (struct mt76_emu_vif *) vif->drv_priv;
+
+	mt76_txq_remove(&dev->mt76, vif->txq);
+
+	mutex_lock(&dev->mutex);
+	dev->vif_mask &= ~BIT(mvif->idx);
+	mutex_unlock(&dev->mutex);
+}
+
+static int
+mt76_emu_config(struct ieee80211_hw *hw, u32 changed)
+{
+	struct mt76_emu_dev *dev = hw->priv;
+
+	mutex_lock(&dev->mutex);
+
+	if (changed & IEEE80211_CONF_CHANGE_CHANNEL) {
+		ieee80211_stop_queues(hw);
+		set_bit(MT76_RESET, &dev->mt76.state);
+		mt76_set_channel(&dev->mt76);
+		clear_bit(MT76_RESET, &dev->mt76.state);
+		mt76_txq_schedule_all(&dev->mt76);
+		ieee80211_wake_queues(hw);
+	}
+
+	mutex_unlock(&dev->mutex);
+
+	return 0;
+}
+
+static void
+mt76_emu_configure_filter(struct ieee80211_hw *hw, unsigned int changed_flags,
+			  unsigned int *total_flags, u64 multicast)
+{
+	/* the loopback firmware does not filter anything */
+	*total_flags &= FIF_ALLMULTI | FIF_FCSFAIL | FIF_CONTROL |
+			FIF_OTHER_BSS | FIF_PSPOLL;
+}
+
+static void
+mt76_emu_bss_info_changed(struct ieee80211_hw *hw, struct ieee80211_vif *vif,
+			  struct ieee80211_bss_conf *info, u32 changed)
+{
+}
+
+static int
+mt76_emu_sta_add(struct ieee80211_hw *hw, struct ieee80211_vif *vif,
+		 struct ieee80211_sta *sta)
+{
+	struct mt76_emu_dev *dev = hw->priv;
+	struct mt76_emu_sta *msta = (struct mt76_emu_sta *) sta->drv_priv;
+	struct mt76_emu_vif *mvif = (struct mt76_emu_vif *) vif->drv_priv;
+	int ret = 0;
+	int idx;
+	int i;
+
+	mutex_lock(&dev->mutex);
+
+	/* the top entries are reserved for per-vif group wcids */
+	idx = mt76_wcid_alloc(dev->wcid_mask, MT_EMU_VIF_WCID(7));
+	if (idx < 0) {
+		ret = -ENOSPC;
+		goto out;
+	}
+
+	msta->vif = mvif;
+	msta->wcid.sta = 1;
+	msta->wcid.idx = idx;
+	msta->wcid.hw_key_idx = -1;
+	for (i = 0; i < ARRAY_SIZE(sta->txq); i++)
+		mt76_txq_init(&dev->mt76, sta->txq[i]);
+
+	if (vif->type == NL80211_IFTYPE_AP)
+		set_bit(MT_WCID_FLAG_CHECK_PS, &msta->wcid.flags);
+
+	rcu_assign_pointer(dev->wcid[idx], &msta->wcid);
+
+out:
+	mutex_unlock(&dev->mutex);
+
+	return ret;
+}
+
+static int
+mt76_emu_sta_remove(struct ieee80211_hw *hw, struct ieee80211_vif *vif,
+		    struct ieee80211_sta *sta)
+{
+	struct mt76_emu_dev *dev = hw->priv;
+	struct mt76_emu_sta *msta = (struct mt76_emu_sta *) sta->drv_priv;
+	int idx = msta->wcid.idx;
+	int i;
+
+	mutex_lock(&dev->mutex);
+	rcu_assign_pointer(dev->wcid[idx], NULL);
+	for (i = 0; i < ARRAY_SIZE(sta->txq); i++)
+		mt76_txq_remove(&dev->mt76, sta->txq[i]);
+	mt76_wcid_free(dev->wcid_mask, idx);
+	mutex_unlock(&dev->mutex);
+
+	return 0;
+}
+
+static int
+mt76_emu_ampdu_action(struct ieee80211_hw *hw, struct ieee80211_vif *vif,
+		      struct ieee80211_ampdu_params *params)
+{
+	enum ieee80211_ampdu_mlme_action action = params->action;
+	struct ieee80211_sta *sta = params->sta;
+	struct mt76_emu_dev *dev = hw->priv;
+	struct mt76_emu_sta *msta = (struct mt76_emu_sta *) sta->drv_priv;
+	struct ieee80211_txq *txq = sta->txq[params->tid];
+	u16 tid = params->tid;
+	u16 *ssn = &params->ssn;
+	struct mt76_txq *mtxq;
+
+	if (!txq)
+		return -EINVAL;
+
+	mtxq = (struct mt76_txq *)txq->drv_priv;
+
+	switch (action) {
+	case IEEE80211_AMPDU_RX_START:
+		mt76_rx_aggr_start(&dev->mt76, &msta->wcid, tid, *ssn,
+				   params->buf_size);
+		break;
+	case IEEE80211_AMPDU_RX_STOP:
+		mt76_rx_aggr_stop(&dev->mt76, &msta->wcid, tid);
+		break;
+	case IEEE80211_AMPDU_TX_OPERATIONAL:
+		mtxq->aggr = true;
+		mtxq->send_bar = false;
+		ieee80211_send_bar(vif, sta->addr, tid, mtxq->agg_ssn);
+		break;
+	case IEEE80211_AMPDU_TX_STOP_FLUSH:
+	case IEEE80211_AMPDU_TX_STOP_FLUSH_CONT:
+		mtxq->aggr = false;
+		ieee80211_send_bar(vif, sta->addr, tid, mtxq->agg_ssn);
+		break;
+	case IEEE80211_AMPDU_TX_START:
+		mtxq->agg_ssn = *ssn << 4;
+		ieee80211_start_tx_ba_cb_irqsafe(vif, sta->addr, tid);
+		break;
+	case IEEE80211_AMPDU_TX_STOP_CONT:
+		mtxq->aggr = false;
+		ieee80211_stop_tx_ba_cb_irqsafe(vif, sta->addr, tid);
+		break;
+	}
+
+	return 0;
+}
+
+static void
+mt76_emu_flush(struct ieee80211_hw *hw, struct ieee80211_vif *vif,
+	       u32 queues, bool drop)
+{
+}
+
+static int
+mt76_emu_set_tim(struct ieee80211_hw *hw, struct ieee80211_sta *sta, bool set)
+{
+	return 0;
+}
+
+const struct ieee80211_ops mt76_emu_ops = {
+	.tx = mt76_emu_tx,
+	.start = mt76_emu_start,
+	.stop = mt76_emu_stop,
+	.add_interface = mt76_emu_add_interface,
+	.remove_interface = mt76_emu_remove_interface,
+	.config = mt76_emu_config,
+	.configure_filter = mt76_emu_configure_filter,
+	.bss_info_changed = mt76_emu_bss_info_changed,
+	.sta_add = mt76_emu_sta_add,
+	.sta_remove = mt76_emu_sta_remove,
+	.flush = mt76_emu_flush,
+	.ampdu_action = mt76_emu_ampdu_action,
+	.wake_tx_queue = mt76_wake_tx_queue,
+	.release_buffered_frames = mt76_release_buffered_frames,
+	.get_survey = mt76_get_survey,
+	.set_tim = mt76_emu_set_tim,
+};
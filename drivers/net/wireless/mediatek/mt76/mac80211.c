@@ -284,6 +284,7 @@ mt76_alloc_device(unsigned int size, const struct ieee80211_ops *ops)
 	spin_lock_init(&dev->lock);
 	spin_lock_init(&dev->cc_lock);
 	init_waitqueue_head(&dev->tx_wait);
+	dev->rx_copybreak = MT_RX_COPYBREAK;
 
 	return dev;
 }
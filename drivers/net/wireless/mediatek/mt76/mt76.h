@@ -29,9 +29,11 @@
 #define MT_TX_RING_SIZE     256
 #define MT_MCU_RING_SIZE    32
 #define MT_RX_BUF_SIZE      2048
+#define MT_RX_COPYBREAK     256
 
 struct mt76_dev;
 struct mt76_wcid;
+struct page_pool;
 
 struct mt76_bus_ops {
 	u32 (*rr)(struct mt76_dev *dev, u32 offset);
@@ -112,6 +114,15 @@ struct mt76_queue {
 
 	dma_addr_t desc_dma;
 	struct sk_buff *rx_head;
+
+	struct page_pool *page_pool;
+	struct page *rx_page;
+	u32 rx_page_offset;
+	struct page **rx_inflight;
+	u16 rx_inflight_head;
+	u16 rx_inflight_count;
+	u32 rx_page_recycle;
+	u32 rx_page_release;
 };
 
 struct mt76_queue_ops {
@@ -198,6 +209,7 @@ struct mt76_rx_tid {
 
 	u8 started:1, stopped:1, timer_pending:1;
 
+	DECLARE_BITMAP(reorder_busy, IEEE80211_MAX_AMPDU_BUF);
 	struct sk_buff *reorder_buf[];
 };
 
@@ -326,6 +338,7 @@ struct mt76_dev {
 	spinlock_t rx_lock;
 	struct napi_struct napi[__MT_RXQ_MAX];
 	struct sk_buff_head rx_skb[__MT_RXQ_MAX];
+	u32 rx_copybreak;
 
 	struct list_head txwi_cache;
 	struct mt76_queue q_tx[__MT_TXQ_MAX];
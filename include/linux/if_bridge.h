@@ -51,6 +51,7 @@ struct br_ip_list {
 #define BR_BCAST_FLOOD		BIT(14)
 #define BR_NEIGH_SUPPRESS	BIT(15)
 #define BR_ISOLATED		BIT(16)
+#define BR_FDB_LAZY_UPDATE	BIT(17)
 
 #define BR_DEFAULT_AGEING_TIME	(300 * HZ)
 
@@ -22,16 +22,29 @@
 #include <linux/list.h>
 #include <linux/skbuff.h>
 #include <linux/poll.h>
+#include <linux/if_ether.h>
 #include <net/net_namespace.h>
 
 struct ppp_channel;
 
+/* Link a channel sends its frames over, see ppp_dev_fill_path(). */
+struct ppp_channel_path {
+	struct net_device *dev;		/* device the link runs over */
+	__be16		proto;		/* ETH_P_PPP_SES */
+	__be16		id;		/* session id */
+	u8		h_dest[ETH_ALEN]; /* address of the peer */
+};
+
 struct ppp_channel_ops {
 	/* Send a packet (or multilink fragment) on this channel.
 	   Returns 1 if it was accepted, 0 if not. */
 	int	(*start_xmit)(struct ppp_channel *, struct sk_buff *);
 	/* Handle an ioctl call that has come in via /dev/ppp. */
 	int	(*ioctl)(struct ppp_channel *, unsigned int, unsigned long);
+	/* Describe the link below the channel, optional.
+	   Called with the channel's downlink lock held, must not sleep. */
+	int	(*fill_path)(struct ppp_channel *,
+			     struct ppp_channel_path *);
 };
 
 struct ppp_channel {
@@ -75,6 +88,18 @@ extern int ppp_unit_number(struct ppp_channel *);
 /* Get the device name associated with a channel, or NULL if none */
 extern char *ppp_dev_name(struct ppp_channel *);
 
+/* Get the link below a PPP device that has a single channel */
+#if IS_ENABLED(CONFIG_PPP)
+extern int ppp_dev_fill_path(const struct net_device *,
+			     struct ppp_channel_path *);
+#else
+static inline int ppp_dev_fill_path(const struct net_device *dev,
+				    struct ppp_channel_path *path)
+{
+	return -EOPNOTSUPP;
+}
+#endif
+
 /*
  * SMP locking notes:
  * The channel code must ensure that when it calls ppp_unregister_channel,
@@ -4279,7 +4279,9 @@ struct cfg80211_cqm_config;
  *	netdev and may otherwise be used by driver read-only, will be update
  *	by cfg80211 on change_interface
  * @mgmt_registrations: list of registrations for management frames
- * @mgmt_registrations_lock: lock for the list
+ * @mgmt_registrations_stype: (private) the same registrations hashed by
+ *	management frame subtype, for the RX path
+ * @mgmt_registrations_lock: lock for the lists
  * @mtx: mutex used to lock data in this struct, may be used by drivers
  *	and some API functions require it held
  * @beacon_interval: beacon interval used on this device for transmitting
@@ -4319,6 +4321,8 @@ struct wireless_dev {
 	u32 identifier;
 
 	struct list_head mgmt_registrations;
+	struct hlist_head
+		mgmt_registrations_stype[(IEEE80211_FCTL_STYPE >> 4) + 1];
 	spinlock_t mgmt_registrations_lock;
 
 	struct mutex mtx;
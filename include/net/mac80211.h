@@ -5530,6 +5530,40 @@ void ieee80211_mark_rx_ba_filtered_frames(struct ieee80211_sta *pubsta, u8 tid,
 					  u16 ssn, u64 filtered,
 					  u16 received_mpdus);
 
+/**
+ * ieee80211_reorder_next_busy - find the next used RX reorder buffer slot
+ * @busy: bitmap of the reorder buffer slots that hold frames
+ * @size: number of slots in the reorder buffer
+ * @index: slot to start looking at
+ *
+ * Drivers that do A-MPDU reordering themselves can track the slots in use
+ * in a bitmap and use this to jump over runs of empty slots instead of
+ * walking the buffer slot by slot, the way mac80211 does for its own
+ * reorder buffer.
+ *
+ * Return: the distance from @index to the next slot that is in use,
+ * wrapping around at @size, or @size if no slot is in use.
+ */
+int ieee80211_reorder_next_busy(const unsigned long *busy, int size,
+				int index);
+
+/**
+ * ieee80211_reorder_skip_empty - move a reorder window over empty slots
+ * @busy: bitmap of the reorder buffer slots that hold frames
+ * @size: number of slots in the reorder buffer
+ * @head: sequence number of the current head of the window
+ * @limit: sequence number the window is being moved up to
+ *
+ * Batched form of releasing frames up to @limit: all empty slots from
+ * @head on are passed over in one step, so the caller only has to handle
+ * the slots that hold frames.
+ *
+ * Return: the sequence number of the first slot in use at or after @head,
+ * but not past @limit.
+ */
+u16 ieee80211_reorder_skip_empty(const unsigned long *busy, int size,
+				 u16 head, u16 limit);
+
 /**
  * ieee80211_send_bar - send a BlockAckReq frame
  *
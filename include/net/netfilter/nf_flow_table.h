@@ -4,6 +4,8 @@
 #include <linux/in.h>
 #include <linux/in6.h>
 #include <linux/netdevice.h>
+#include <linux/if_pppox.h>
+#include <linux/ppp_defs.h>
 #include <linux/rhashtable-types.h>
 #include <linux/rcupdate.h>
 #include <linux/netfilter/nf_conntrack_tuple_common.h>
@@ -20,11 +22,16 @@ struct nf_flowtable_type {
 	struct module			*owner;
 };
 
+#define NF_FLOW_GC_SLOTS	128
+
 struct nf_flowtable {
 	struct list_head		list;
 	struct rhashtable		rhashtable;
 	const struct nf_flowtable_type	*type;
 	struct delayed_work		gc_work;
+	spinlock_t			gc_lock;
+	u32				gc_next;
+	struct hlist_head		gc_wheel[NF_FLOW_GC_SLOTS];
 };
 
 enum flow_offload_tuple_dir {
@@ -48,6 +55,8 @@ struct flow_offload_tuple {
 	};
 
 	int				iifidx;
+	/* PPPoE session the packets arrive in on iifidx, 0 if none */
+	__be16				pppoe_sid;
 
 	u8				l3proto;
 	u8				l4proto;
@@ -56,6 +65,7 @@ struct flow_offload_tuple {
 	int				oifidx;
 
 	u16				mtu;
+	u8				pppoe_remote[ETH_ALEN];
 
 	struct dst_entry		*dst_cache;
 };
@@ -73,6 +83,7 @@ struct flow_offload_tuple_rhash {
 struct flow_offload {
 	struct flow_offload_tuple_rhash		tuplehash[FLOW_OFFLOAD_DIR_MAX];
 	u32					flags;
+	struct hlist_node			gc_node;
 	union {
 		/* Your private driver data here. */
 		u32		timeout;
@@ -85,6 +96,8 @@ struct nf_flow_route {
 	struct {
 		struct dst_entry	*dst;
 		int			ifindex;
+		__be16			pppoe_sid;
+		u8			pppoe_remote[ETH_ALEN];
 	} tuple[FLOW_OFFLOAD_DIR_MAX];
 };
 
@@ -104,7 +117,10 @@ void nf_flow_table_cleanup(struct net *net, struct net_device *dev);
 int nf_flow_table_init(struct nf_flowtable *flow_table);
 void nf_flow_table_free(struct nf_flowtable *flow_table);
 
-void flow_offload_teardown(struct flow_offload *flow);
+void flow_offload_teardown(struct nf_flowtable *flow_table,
+			   struct flow_offload *flow);
+void flow_offload_acct(struct flow_offload *flow,
+		       enum flow_offload_tuple_dir dir, unsigned int len);
 static inline void flow_offload_dead(struct flow_offload *flow)
 {
 	flow->flags |= FLOW_OFFLOAD_DYING;
@@ -121,6 +137,22 @@ struct flow_ports {
 	__be16 source, dest;
 };
 
+/* Protocol carried by a PPPoE session frame, 0 if it is not IPv4 or IPv6. */
+static inline __be16 nf_flow_pppoe_proto(struct sk_buff *skb)
+{
+	if (!pskb_may_pull(skb, PPPOE_SES_HLEN))
+		return 0;
+
+	switch (*(__be16 *)(skb->data + sizeof(struct pppoe_hdr))) {
+	case htons(PPP_IP):
+		return htons(ETH_P_IP);
+	case htons(PPP_IPV6):
+		return htons(ETH_P_IPV6);
+	}
+
+	return 0;
+}
+
 unsigned int nf_flow_offload_ip_hook(void *priv, struct sk_buff *skb,
 				     const struct nf_hook_state *state);
 unsigned int nf_flow_offload_ipv6_hook(void *priv, struct sk_buff *skb,
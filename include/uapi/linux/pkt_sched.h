@@ -971,6 +971,25 @@ enum {
 #define TCA_ETF_MAX (__TCA_ETF_MAX - 1)
 
 
+/* MTB */
+enum {
+	TCA_MTB_UNSPEC,
+	TCA_MTB_PAD,
+	TCA_MTB_GROUP,
+	TCA_MTB_RATE64,
+	TCA_MTB_BURST,
+	TCA_MTB_LIMIT,
+	__TCA_MTB_MAX,
+};
+
+#define TCA_MTB_MAX (__TCA_MTB_MAX - 1)
+
+struct tc_mtb_xstats {
+	__u64	share;		/* current share of the group rate, bytes/s */
+	__u32	members;	/* queues sharing the group rate */
+};
+
+
 /* CAKE */
 enum {
 	TCA_CAKE_UNSPEC,
@@ -991,6 +1010,7 @@ enum {
 	TCA_CAKE_INGRESS,
 	TCA_CAKE_ACK_FILTER,
 	TCA_CAKE_SPLIT_GSO,
+	TCA_CAKE_SHAPER_GROUP,
 	__TCA_CAKE_MAX
 };
 #define TCA_CAKE_MAX	(__TCA_CAKE_MAX - 1)
@@ -338,9 +338,7 @@ batadv_iv_ogm_orig_get(struct batadv_priv *bat_priv, const u8 *addr)
 		goto free_orig_node;
 
 	kref_get(&orig_node->refcount);
-	hash_added = batadv_hash_add(bat_priv->orig_hash, batadv_compare_orig,
-				     batadv_choose_orig, orig_node,
-				     &orig_node->hash_entry);
+	hash_added = batadv_orig_hash_add(bat_priv, orig_node);
 	if (hash_added != 0)
 		goto free_orig_node_hash;
 
@@ -389,6 +387,7 @@ static int batadv_iv_ogm_iface_enable(struct batadv_hard_iface *hard_iface)
 		return -ENOMEM;
 
 	hard_iface->bat_iv.ogm_buff = ogm_buff;
+	INIT_HLIST_HEAD(&hard_iface->bat_iv.aggr_list);
 
 	batadv_ogm_packet = (struct batadv_ogm_packet *)ogm_buff;
 	batadv_ogm_packet->packet_type = BATADV_IV_OGM;
@@ -578,7 +577,6 @@ static void batadv_iv_ogm_emit(struct batadv_forw_packet *forw_packet)
  * @send_time: timestamp (jiffies) when the packet is to be sent
  * @directlink: true if this is a direct link packet
  * @if_incoming: interface where the packet was received
- * @if_outgoing: interface for which the retransmission should be considered
  * @forw_packet: the forwarded packet which should be checked
  *
  * Return: true if new_packet can be aggregated with forw_packet
@@ -589,7 +587,6 @@ batadv_iv_ogm_can_aggregate(const struct batadv_ogm_packet *new_bat_ogm_packet,
 			    int packet_len, unsigned long send_time,
 			    bool directlink,
 			    const struct batadv_hard_iface *if_incoming,
-			    const struct batadv_hard_iface *if_outgoing,
 			    const struct batadv_forw_packet *forw_packet)
 {
 	struct batadv_ogm_packet *batadv_ogm_packet;
@@ -617,10 +614,6 @@ batadv_iv_ogm_can_aggregate(const struct batadv_ogm_packet *new_bat_ogm_packet,
 	if (aggregated_bytes > BATADV_MAX_AGGREGATION_BYTES)
 		return false;
 
-	/* packet is not leaving on the same interface. */
-	if (forw_packet->if_outgoing != if_outgoing)
-		return false;
-
 	/* check aggregation compatibility
 	 * -> direct link packets are broadcasted on
 	 *    their interface only
@@ -734,11 +727,25 @@ static void batadv_iv_ogm_aggregate_new(const unsigned char *packet_buff,
 	INIT_DELAYED_WORK(&forw_packet_aggr->delayed_work,
 			  batadv_iv_send_outstanding_bat_ogm_packet);
 
+	batadv_inc_counter(bat_priv, BATADV_CNT_OGM_AGGR);
+	batadv_inc_counter(bat_priv, BATADV_CNT_OGM_AGGR_OGMS);
+
+	/* make it a candidate for aggregation before its delayed work is
+	 * queued, nobody can send and free it until then
+	 */
+	if (packet_len + BATADV_OGM_HLEN + ETH_HLEN <= skb_size) {
+		spin_lock_bh(&bat_priv->forw_bat_list_lock);
+		hlist_add_head(&forw_packet_aggr->aggr_list,
+			       &if_outgoing->bat_iv.aggr_list);
+		spin_unlock_bh(&bat_priv->forw_bat_list_lock);
+	}
+
 	batadv_forw_packet_ogmv1_queue(bat_priv, forw_packet_aggr, send_time);
 }
 
 /* aggregate a new packet into the existing ogm packet */
-static void batadv_iv_ogm_aggregate(struct batadv_forw_packet *forw_packet_aggr,
+static void batadv_iv_ogm_aggregate(struct batadv_priv *bat_priv,
+				    struct batadv_forw_packet *forw_packet_aggr,
 				    const unsigned char *packet_buff,
 				    int packet_len, bool direct_link)
 {
@@ -753,6 +760,13 @@ static void batadv_iv_ogm_aggregate(struct batadv_forw_packet *forw_packet_aggr,
 		new_direct_link_flag = BIT(forw_packet_aggr->num_packets);
 		forw_packet_aggr->direct_link_flags |= new_direct_link_flag;
 	}
+
+	/* no other OGM fits anymore, stop offering it for aggregation */
+	if (forw_packet_aggr->packet_len + BATADV_OGM_HLEN >
+	    BATADV_MAX_AGGREGATION_BYTES)
+		hlist_del_init(&forw_packet_aggr->aggr_list);
+
+	batadv_inc_counter(bat_priv, BATADV_CNT_OGM_AGGR_OGMS);
 }
 
 /**
@@ -785,17 +799,19 @@ static void batadv_iv_ogm_queue_add(struct batadv_priv *bat_priv,
 	direct_link = !!(batadv_ogm_packet->flags & BATADV_DIRECTLINK);
 	max_aggregation_jiffies = msecs_to_jiffies(BATADV_MAX_AGGREGATION_MS);
 
-	/* find position for the packet in the forward queue */
+	/* find position for the packet in the forward queue - only the
+	 * aggregates leaving on the same interface are candidates
+	 */
 	spin_lock_bh(&bat_priv->forw_bat_list_lock);
 	/* own packets are not to be aggregated */
 	if (atomic_read(&bat_priv->aggregated_ogms) && !own_packet) {
 		hlist_for_each_entry(forw_packet_pos,
-				     &bat_priv->forw_bat_list, list) {
+				     &if_outgoing->bat_iv.aggr_list,
+				     aggr_list) {
 			if (batadv_iv_ogm_can_aggregate(batadv_ogm_packet,
 							bat_priv, packet_len,
 							send_time, direct_link,
 							if_incoming,
-							if_outgoing,
 							forw_packet_pos)) {
 				forw_packet_aggr = forw_packet_pos;
 				break;
@@ -822,8 +838,8 @@ static void batadv_iv_ogm_queue_add(struct batadv_priv *bat_priv,
 					    if_incoming, if_outgoing,
 					    own_packet);
 	} else {
-		batadv_iv_ogm_aggregate(forw_packet_aggr, packet_buff,
-					packet_len, direct_link);
+		batadv_iv_ogm_aggregate(bat_priv, forw_packet_aggr,
+					packet_buff, packet_len, direct_link);
 		spin_unlock_bh(&bat_priv->forw_bat_list_lock);
 	}
 }
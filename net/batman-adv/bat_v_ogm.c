@@ -43,7 +43,6 @@
 
 #include "bat_algo.h"
 #include "hard-interface.h"
-#include "hash.h"
 #include "log.h"
 #include "originator.h"
 #include "routing.h"
@@ -75,9 +74,7 @@ struct batadv_orig_node *batadv_v_ogm_orig_get(struct batadv_priv *bat_priv,
 		return NULL;
 
 	kref_get(&orig_node->refcount);
-	hash_added = batadv_hash_add(bat_priv->orig_hash, batadv_compare_orig,
-				     batadv_choose_orig, orig_node,
-				     &orig_node->hash_entry);
+	hash_added = batadv_orig_hash_add(bat_priv, orig_node);
 	if (hash_added != 0) {
 		/* remove refcnt for newly created orig_node and hash entry */
 		batadv_orig_node_put(orig_node);
@@ -672,12 +672,17 @@ batadv_hardif_activate_interface(struct batadv_hard_iface *hard_iface)
 static void
 batadv_hardif_deactivate_interface(struct batadv_hard_iface *hard_iface)
 {
+	struct batadv_priv *bat_priv;
+
 	if (hard_iface->if_status != BATADV_IF_ACTIVE &&
 	    hard_iface->if_status != BATADV_IF_TO_BE_ACTIVATED)
 		return;
 
 	hard_iface->if_status = BATADV_IF_INACTIVE;
 
+	bat_priv = netdev_priv(hard_iface->soft_iface);
+	atomic_set(&bat_priv->orig_purge_iface_down, 1);
+
 	batadv_info(hard_iface->soft_iface, "Interface deactivated: %s\n",
 		    hard_iface->net_dev->name);
 
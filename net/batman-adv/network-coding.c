@@ -1038,12 +1038,60 @@ static u8 batadv_nc_random_weight_tq(u8 tq)
  * @src: byte array to XOR from
  * @len: length of destination array
  */
-static void batadv_nc_memxor(char *dst, const char *src, unsigned int len)
+static void batadv_nc_memxor(u8 *dst, const u8 *src, unsigned int len)
 {
-	unsigned int i;
+	const unsigned int step = sizeof(unsigned long);
+
+	/* work on whole words where the architecture allows it */
+	if (IS_ENABLED(CONFIG_HAVE_EFFICIENT_UNALIGNED_ACCESS) ||
+	    IS_ALIGNED((unsigned long)dst | (unsigned long)src, step)) {
+		while (len >= step) {
+			*(unsigned long *)dst ^= *(const unsigned long *)src;
+			dst += step;
+			src += step;
+			len -= step;
+		}
+	}
+
+	while (len--)
+		*dst++ ^= *src++;
+}
+
+/**
+ * batadv_nc_skb_xor() - XOR the data of an skb into a buffer
+ * @dst: byte array to XOR into
+ * @skb: skb to XOR from, does not have to be linear
+ * @offset: offset in @skb to start reading from
+ * @len: number of bytes to XOR into @dst
+ *
+ * The fragments of @skb are processed in place, so it does not have to be
+ * linearized first. At most the remaining data of @skb is used.
+ */
+static void batadv_nc_skb_xor(u8 *dst, struct sk_buff *skb,
+			      unsigned int offset, unsigned int len)
+{
+	struct skb_seq_state st;
+	unsigned int consumed = 0;
+	unsigned int chunk;
+	const u8 *data;
 
-	for (i = 0; i < len; ++i)
-		dst[i] ^= src[i];
+	if (offset >= skb->len)
+		return;
+
+	len = min(len, skb->len - offset);
+	skb_prepare_seq_read(skb, offset, offset + len, &st);
+
+	while (consumed < len) {
+		chunk = skb_seq_read(consumed, &data, &st);
+		if (!chunk)
+			break;
+
+		chunk = min(chunk, len - consumed);
+		batadv_nc_memxor(dst + consumed, data, chunk);
+		consumed += chunk;
+	}
+
+	skb_abort_seq_read(&st);
 }
 
 /**
@@ -1151,7 +1199,8 @@ static bool batadv_nc_code_packets(struct batadv_priv *bat_priv,
 	/* coding_len is used when decoding the packet shorter packet */
 	coding_len = skb_src->len - unicast_size;
 
-	if (skb_linearize(skb_dest) < 0 || skb_linearize(skb_src) < 0)
+	/* only the coded packet is modified, skb_src is read in place */
+	if (skb_linearize(skb_dest) < 0)
 		goto out;
 
 	skb_push(skb_dest, header_add);
@@ -1179,8 +1228,8 @@ static bool batadv_nc_code_packets(struct batadv_priv *bat_priv,
 	coded_packet->coded_len = htons(coding_len);
 
 	/* This is where the magic happens: Code skb_src into skb_dest */
-	batadv_nc_memxor(skb_dest->data + coded_size,
-			 skb_src->data + unicast_size, coding_len);
+	batadv_nc_skb_xor(skb_dest->data + coded_size, skb_src, unicast_size,
+			  coding_len);
 
 	/* Update counters accordingly */
 	if (BATADV_SKB_CB(skb_src)->decoded &&
@@ -1714,9 +1763,8 @@ batadv_nc_skb_decode_packet(struct batadv_priv *bat_priv, struct sk_buff *skb,
 	/* Here the magic is reversed:
 	 *   extract the missing packet from the received coded packet
 	 */
-	batadv_nc_memxor(skb->data + h_size,
-			 nc_packet->skb->data + h_size,
-			 coding_len);
+	batadv_nc_skb_xor(skb->data + h_size, nc_packet->skb, h_size,
+			  coding_len);
 
 	/* Resize decoded skb if decoded with larger packet */
 	if (nc_packet->skb->len > coding_len + h_size) {
@@ -1848,13 +1896,12 @@ static int batadv_nc_recv_coded_packet(struct sk_buff *skb,
 		goto free_skb;
 	}
 
-	/* Make skb's linear, because decoding accesses the entire buffer */
+	/* Make skb linear, because decoding rewrites the entire buffer. The
+	 * stored packet is only read and can stay fragmented.
+	 */
 	if (skb_linearize(skb) < 0)
 		goto free_nc_packet;
 
-	if (skb_linearize(nc_packet->skb) < 0)
-		goto free_nc_packet;
-
 	/* Decode the packet */
 	unicast_packet = batadv_nc_skb_decode_packet(bat_priv, skb, nc_packet);
 	if (!unicast_packet) {
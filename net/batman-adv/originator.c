@@ -32,6 +32,7 @@
 #include <linux/netlink.h>
 #include <linux/rculist.h>
 #include <linux/rcupdate.h>
+#include <linux/rhashtable.h>
 #include <linux/seq_file.h>
 #include <linux/skbuff.h>
 #include <linux/slab.h>
@@ -58,6 +59,13 @@
 /* hash class keys */
 static struct lock_class_key batadv_orig_hash_lock_class_key;
 
+static const struct rhashtable_params batadv_orig_index_params = {
+	.head_offset = offsetof(struct batadv_orig_node, hash_node),
+	.key_offset = offsetof(struct batadv_orig_node, orig),
+	.key_len = ETH_ALEN,
+	.automatic_shrinking = true,
+};
+
 /**
  * batadv_orig_hash_find() - Find and return originator from orig_hash
  * @bat_priv: the bat priv with all the soft interface information
@@ -68,31 +76,52 @@ static struct lock_class_key batadv_orig_hash_lock_class_key;
 struct batadv_orig_node *
 batadv_orig_hash_find(struct batadv_priv *bat_priv, const void *data)
 {
-	struct batadv_hashtable *hash = bat_priv->orig_hash;
-	struct hlist_head *head;
-	struct batadv_orig_node *orig_node, *orig_node_tmp = NULL;
-	int index;
+	struct batadv_orig_node *orig_node;
 
-	if (!hash)
+	if (!bat_priv->orig_hash)
 		return NULL;
 
-	index = batadv_choose_orig(data, hash->size);
-	head = &hash->table[index];
-
 	rcu_read_lock();
-	hlist_for_each_entry_rcu(orig_node, head, hash_entry) {
-		if (!batadv_compare_eth(orig_node, data))
-			continue;
+	orig_node = rhashtable_lookup(&bat_priv->orig_index, data,
+				      batadv_orig_index_params);
+	if (orig_node && !kref_get_unless_zero(&orig_node->refcount))
+		orig_node = NULL;
+	rcu_read_unlock();
 
-		if (!kref_get_unless_zero(&orig_node->refcount))
-			continue;
+	return orig_node;
+}
 
-		orig_node_tmp = orig_node;
-		break;
-	}
-	rcu_read_unlock();
+/**
+ * batadv_orig_hash_add() - Add originator to orig_hash and its lookup index
+ * @bat_priv: the bat priv with all the soft interface information
+ * @orig_node: the originator to add
+ *
+ * Return: 0 on success, 1 if the originator already is in the hash and -1 on
+ * error.
+ */
+int batadv_orig_hash_add(struct batadv_priv *bat_priv,
+			 struct batadv_orig_node *orig_node)
+{
+	int ret;
 
-	return orig_node_tmp;
+	/* the index rejects duplicates, so it has to be updated first */
+	ret = rhashtable_lookup_insert_fast(&bat_priv->orig_index,
+					    &orig_node->hash_node,
+					    batadv_orig_index_params);
+	if (ret == -EEXIST)
+		return 1;
+	if (ret < 0)
+		return -1;
+
+	ret = batadv_hash_add(bat_priv->orig_hash, batadv_compare_orig,
+			      batadv_choose_orig, orig_node,
+			      &orig_node->hash_entry);
+	if (ret != 0)
+		rhashtable_remove_fast(&bat_priv->orig_index,
+				       &orig_node->hash_node,
+				       batadv_orig_index_params);
+
+	return ret;
 }
 
 static void batadv_purge_orig(struct work_struct *work);
@@ -224,9 +253,15 @@ int batadv_originator_init(struct batadv_priv *bat_priv)
 	if (!bat_priv->orig_hash)
 		goto err;
 
+	if (rhashtable_init(&bat_priv->orig_index,
+			    &batadv_orig_index_params) < 0)
+		goto free_hash;
+
 	batadv_hash_set_lock_class(bat_priv->orig_hash,
 				   &batadv_orig_hash_lock_class_key);
 
+	bat_priv->orig_purge_slice = 0;
+	atomic_set(&bat_priv->orig_purge_iface_down, 0);
 	INIT_DELAYED_WORK(&bat_priv->orig_work, batadv_purge_orig);
 	queue_delayed_work(batadv_event_workqueue,
 			   &bat_priv->orig_work,
@@ -234,6 +269,9 @@ int batadv_originator_init(struct batadv_priv *bat_priv)
 
 	return 0;
 
+free_hash:
+	batadv_hash_destroy(bat_priv->orig_hash);
+	bat_priv->orig_hash = NULL;
 err:
 	return -ENOMEM;
 }
@@ -1006,6 +1044,7 @@ void batadv_originator_free(struct batadv_priv *bat_priv)
 	}
 
 	batadv_hash_destroy(hash);
+	rhashtable_destroy(&bat_priv->orig_index);
 }
 
 /**
@@ -1054,6 +1093,7 @@ struct batadv_orig_node *batadv_orig_node_new(struct batadv_priv *bat_priv,
 	orig_node->tt_buff = NULL;
 	orig_node->tt_buff_len = 0;
 	orig_node->last_seen = jiffies;
+	orig_node->purge_at = jiffies;
 	reset_time = jiffies - 1 - msecs_to_jiffies(BATADV_RESET_PROTECTION_MS);
 	orig_node->bcast_seqno_reset = reset_time;
 
@@ -1185,6 +1225,9 @@ batadv_purge_orig_ifinfo(struct batadv_priv *bat_priv,
  * @bat_priv: the bat priv with all the soft interface information
  * @orig_node: orig node which is to be checked
  *
+ * Also updates orig_node->purge_at with the time the oldest remaining neighbor
+ * will time out.
+ *
  * Return: true if any neighbor was purged, false otherwise
  */
 static bool
@@ -1194,7 +1237,7 @@ batadv_purge_orig_neighbors(struct batadv_priv *bat_priv,
 	struct hlist_node *node_tmp;
 	struct batadv_neigh_node *neigh_node;
 	bool neigh_purged = false;
-	unsigned long last_seen;
+	unsigned long last_seen, oldest = jiffies;
 	struct batadv_hard_iface *if_incoming;
 
 	spin_lock_bh(&orig_node->neigh_list_lock);
@@ -1231,9 +1274,14 @@ batadv_purge_orig_neighbors(struct batadv_priv *bat_priv,
 			 * deleted, but some interface has been removed.
 			 */
 			batadv_purge_neigh_ifinfo(bat_priv, neigh_node);
+
+			if (time_before(last_seen, oldest))
+				oldest = last_seen;
 		}
 	}
 
+	orig_node->purge_at = oldest + msecs_to_jiffies(BATADV_PURGE_TIMEOUT);
+
 	spin_unlock_bh(&orig_node->neigh_list_lock);
 	return neigh_purged;
 }
@@ -1277,6 +1325,8 @@ batadv_find_best_neighbor(struct batadv_priv *bat_priv,
  * batadv_purge_orig_node() - purges obsolete information from an orig_node
  * @bat_priv: the bat priv with all the soft interface information
  * @orig_node: orig node which is to be checked
+ * @force: check the neighbors and ifinfos even if none of them can have
+ *  timed out yet
  *
  * This function checks if the orig_node or substructures of it have become
  * obsolete, and purges this information if that's the case.
@@ -1284,7 +1334,8 @@ batadv_find_best_neighbor(struct batadv_priv *bat_priv,
  * Return: true if the orig_node is to be removed, false otherwise.
  */
 static bool batadv_purge_orig_node(struct batadv_priv *bat_priv,
-				   struct batadv_orig_node *orig_node)
+				   struct batadv_orig_node *orig_node,
+				   bool force)
 {
 	struct batadv_neigh_node *best_neigh_node;
 	struct batadv_hard_iface *hard_iface;
@@ -1298,6 +1349,13 @@ static bool batadv_purge_orig_node(struct batadv_priv *bat_priv,
 			   jiffies_to_msecs(orig_node->last_seen));
 		return true;
 	}
+
+	/* the neighbor lists only have to be locked and walked when one of
+	 * the neighbors can have timed out or an interface went down
+	 */
+	if (!force && !time_after(jiffies, orig_node->purge_at))
+		return false;
+
 	changed_ifinfo = batadv_purge_orig_ifinfo(bat_priv, orig_node);
 	changed_neigh = batadv_purge_orig_neighbors(bat_priv, orig_node);
 
@@ -1340,10 +1398,14 @@ static bool batadv_purge_orig_node(struct batadv_priv *bat_priv,
 }
 
 /**
- * batadv_purge_orig_ref() - Purge all outdated originators
+ * batadv_purge_orig_buckets() - Purge outdated originators of some buckets
  * @bat_priv: the bat priv with all the soft interface information
+ * @first: first bucket of the orig_hash to check
+ * @last: bucket after the last one to check
+ * @force: check all neighbors, not only the ones which can have timed out
  */
-void batadv_purge_orig_ref(struct batadv_priv *bat_priv)
+static void batadv_purge_orig_buckets(struct batadv_priv *bat_priv,
+				      u32 first, u32 last, bool force)
 {
 	struct batadv_hashtable *hash = bat_priv->orig_hash;
 	struct hlist_node *node_tmp;
@@ -1352,20 +1414,21 @@ void batadv_purge_orig_ref(struct batadv_priv *bat_priv)
 	struct batadv_orig_node *orig_node;
 	u32 i;
 
-	if (!hash)
-		return;
-
 	/* for all origins... */
-	for (i = 0; i < hash->size; i++) {
+	for (i = first; i < last; i++) {
 		head = &hash->table[i];
 		list_lock = &hash->list_locks[i];
 
 		spin_lock_bh(list_lock);
 		hlist_for_each_entry_safe(orig_node, node_tmp,
 					  head, hash_entry) {
-			if (batadv_purge_orig_node(bat_priv, orig_node)) {
+			if (batadv_purge_orig_node(bat_priv, orig_node,
+						   force)) {
 				batadv_gw_node_delete(bat_priv, orig_node);
 				hlist_del_rcu(&orig_node->hash_entry);
+				rhashtable_remove_fast(&bat_priv->orig_index,
+						       &orig_node->hash_node,
+						       batadv_orig_index_params);
 				batadv_tt_global_del_orig(orig_node->bat_priv,
 							  orig_node, -1,
 							  "originator timed out");
@@ -1378,7 +1441,20 @@ void batadv_purge_orig_ref(struct batadv_priv *bat_priv)
 		}
 		spin_unlock_bh(list_lock);
 	}
+}
 
+/**
+ * batadv_purge_orig_ref() - Purge all outdated originators
+ * @bat_priv: the bat priv with all the soft interface information
+ */
+void batadv_purge_orig_ref(struct batadv_priv *bat_priv)
+{
+	struct batadv_hashtable *hash = bat_priv->orig_hash;
+
+	if (!hash)
+		return;
+
+	batadv_purge_orig_buckets(bat_priv, 0, hash->size, true);
 	batadv_gw_election(bat_priv);
 }
 
@@ -1386,13 +1462,38 @@ static void batadv_purge_orig(struct work_struct *work)
 {
 	struct delayed_work *delayed_work;
 	struct batadv_priv *bat_priv;
+	struct batadv_hashtable *hash;
+	u32 slice, first, last;
 
 	delayed_work = to_delayed_work(work);
 	bat_priv = container_of(delayed_work, struct batadv_priv, orig_work);
-	batadv_purge_orig_ref(bat_priv);
+	hash = bat_priv->orig_hash;
+
+	/* spread the walk over the period: each run only checks a slice of the
+	 * buckets and skips originators without any neighbor due to expire
+	 */
+	slice = bat_priv->orig_purge_slice;
+	first = hash->size * slice / BATADV_ORIG_PURGE_SLICES;
+	last = hash->size * (slice + 1) / BATADV_ORIG_PURGE_SLICES;
+
+	/* a hard interface went down: neighbors and ifinfos referencing it
+	 * have to go, regardless of their timeouts
+	 */
+	if (atomic_xchg(&bat_priv->orig_purge_iface_down, 0))
+		batadv_purge_orig_buckets(bat_priv, 0, hash->size, true);
+	else
+		batadv_purge_orig_buckets(bat_priv, first, last, false);
+
+	if (++slice == BATADV_ORIG_PURGE_SLICES) {
+		slice = 0;
+		batadv_gw_election(bat_priv);
+	}
+	bat_priv->orig_purge_slice = slice;
+
 	queue_delayed_work(batadv_event_workqueue,
 			   &bat_priv->orig_work,
-			   msecs_to_jiffies(BATADV_ORIG_WORK_PERIOD));
+			   msecs_to_jiffies(BATADV_ORIG_WORK_PERIOD /
+					    BATADV_ORIG_PURGE_SLICES));
 }
 
 #ifdef CONFIG_BATMAN_ADV_DEBUGFS
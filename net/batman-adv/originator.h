@@ -102,5 +102,7 @@ static inline u32 batadv_choose_orig(const void *data, u32 size)
 
 struct batadv_orig_node *
 batadv_orig_hash_find(struct batadv_priv *bat_priv, const void *data);
+int batadv_orig_hash_add(struct batadv_priv *bat_priv,
+			 struct batadv_orig_node *orig_node);
 
 #endif /* _NET_BATMAN_ADV_ORIGINATOR_H_ */
@@ -545,6 +545,7 @@ batadv_forw_packet_alloc(struct batadv_hard_iface *if_incoming,
 		kref_get(&if_outgoing->refcount);
 
 	INIT_HLIST_NODE(&forw_packet->list);
+	INIT_HLIST_NODE(&forw_packet->aggr_list);
 	INIT_HLIST_NODE(&forw_packet->cleanup_list);
 	forw_packet->skb = skb;
 	forw_packet->queue_left = queue_left;
@@ -599,6 +600,7 @@ bool batadv_forw_packet_steal(struct batadv_forw_packet *forw_packet,
 	}
 
 	hlist_del_init(&forw_packet->list);
+	hlist_del_init(&forw_packet->aggr_list);
 
 	/* Just to spot misuse of this function */
 	hlist_add_fake(&forw_packet->cleanup_list);
@@ -639,6 +641,7 @@ batadv_forw_packet_list_steal(struct hlist_head *forw_list,
 			continue;
 
 		hlist_del(&forw_packet->list);
+		hlist_del_init(&forw_packet->aggr_list);
 		hlist_add_head(&forw_packet->cleanup_list, cleanup_list);
 	}
 }
@@ -958,6 +958,8 @@ static const struct {
 	{ "mgmt_tx_bytes" },
 	{ "mgmt_rx" },
 	{ "mgmt_rx_bytes" },
+	{ "ogm_aggr" },
+	{ "ogm_aggr_ogms" },
 	{ "frag_tx" },
 	{ "frag_tx_bytes" },
 	{ "frag_rx" },
@@ -42,6 +42,7 @@
 #include <linux/netlink.h>
 #include <linux/rculist.h>
 #include <linux/rcupdate.h>
+#include <linux/rhashtable.h>
 #include <linux/seq_file.h>
 #include <linux/skbuff.h>
 #include <linux/slab.h>
@@ -126,9 +127,67 @@ static inline u32 batadv_choose_tt(const void *data, u32 size)
 	return hash % size;
 }
 
+/* the (addr, vid) tuple at the start of the tt_common_entry is the key */
+static const struct rhashtable_params batadv_tt_index_params = {
+	.head_offset = offsetof(struct batadv_tt_common_entry, hash_node),
+	.key_offset = offsetof(struct batadv_tt_common_entry, addr),
+	.key_len = ETH_ALEN + sizeof(unsigned short),
+	.automatic_shrinking = true,
+};
+
+/**
+ * batadv_tt_hash_add() - add a client to a hash table and its lookup index
+ * @hash: the hash table used to walk over the clients
+ * @index: the resizable lookup index belonging to @hash
+ * @tt: the client to add
+ *
+ * Return: 0 on success, 1 if the client already is in the hash and -1 on
+ * error.
+ */
+static int batadv_tt_hash_add(struct batadv_hashtable *hash,
+			      struct rhashtable *index,
+			      struct batadv_tt_common_entry *tt)
+{
+	int ret;
+
+	BUILD_BUG_ON(offsetof(struct batadv_tt_common_entry, vid) !=
+		     offsetof(struct batadv_tt_common_entry, addr) + ETH_ALEN);
+
+	/* the index rejects duplicates, so it has to be updated first */
+	ret = rhashtable_lookup_insert_fast(index, &tt->hash_node,
+					    batadv_tt_index_params);
+	if (ret == -EEXIST)
+		return 1;
+	if (ret < 0)
+		return -1;
+
+	ret = batadv_hash_add(hash, batadv_compare_tt, batadv_choose_tt, tt,
+			      &tt->hash_entry);
+	if (ret != 0)
+		rhashtable_remove_fast(index, &tt->hash_node,
+				       batadv_tt_index_params);
+
+	return ret;
+}
+
+/**
+ * batadv_tt_hash_unlink() - remove a client from a hash bucket and its index
+ * @index: the resizable lookup index the client is stored in
+ * @tt: the client to remove
+ *
+ * The caller must hold the lock of the hash bucket @tt is linked to.
+ */
+static void batadv_tt_hash_unlink(struct rhashtable *index,
+				  struct batadv_tt_common_entry *tt)
+{
+	hlist_del_init_rcu(&tt->hash_entry);
+	rhashtable_remove_fast(index, &tt->hash_node, batadv_tt_index_params);
+}
+
 /**
- * batadv_tt_hash_find() - look for a client in the given hash table
- * @hash: the hash table to search
+ * batadv_tt_hash_find() - look for a client in the given lookup index
+ * @hash: the hash table the index belongs to
+ * @index: the resizable lookup index to search
  * @addr: the mac address of the client to look for
  * @vid: VLAN identifier
  *
@@ -136,12 +195,10 @@ static inline u32 batadv_choose_tt(const void *data, u32 size)
  * found, NULL otherwise.
  */
 static struct batadv_tt_common_entry *
-batadv_tt_hash_find(struct batadv_hashtable *hash, const u8 *addr,
-		    unsigned short vid)
+batadv_tt_hash_find(struct batadv_hashtable *hash, struct rhashtable *index,
+		    const u8 *addr, unsigned short vid)
 {
-	struct hlist_head *head;
-	struct batadv_tt_common_entry to_search, *tt, *tt_tmp = NULL;
-	u32 index;
+	struct batadv_tt_common_entry to_search, *tt;
 
 	if (!hash)
 		return NULL;
@@ -149,26 +206,149 @@ batadv_tt_hash_find(struct batadv_hashtable *hash, const u8 *addr,
 	ether_addr_copy(to_search.addr, addr);
 	to_search.vid = vid;
 
-	index = batadv_choose_tt(&to_search, hash->size);
-	head = &hash->table[index];
-
 	rcu_read_lock();
-	hlist_for_each_entry_rcu(tt, head, hash_entry) {
-		if (!batadv_compare_eth(tt, addr))
-			continue;
+	tt = rhashtable_lookup(index, to_search.addr, batadv_tt_index_params);
+	if (tt && !kref_get_unless_zero(&tt->refcount))
+		tt = NULL;
+	rcu_read_unlock();
 
-		if (tt->vid != vid)
-			continue;
+	return tt;
+}
 
-		if (!kref_get_unless_zero(&tt->refcount))
-			continue;
+/**
+ * batadv_tt_entry_crc() - compute the CRC32C contribution of a single client
+ * @vid: VLAN identifier of the client
+ * @flags: TT sync flags of the client
+ * @addr: the mac address of the client
+ *
+ * See batadv_tt_global_crc() for how the contributions are combined.
+ *
+ * Return: the CRC32C of the client
+ */
+static u32 batadv_tt_entry_crc(unsigned short vid, u8 flags, const u8 *addr)
+{
+	__be16 tmp_vid;
+	u32 crc;
 
-		tt_tmp = tt;
-		break;
+	/* use network order to read the VID: this ensures that every node
+	 * reads the bytes in the same order.
+	 */
+	tmp_vid = htons(vid);
+	crc = crc32c(0, &tmp_vid, sizeof(tmp_vid));
+
+	/* compute the CRC on flags that have to be kept in sync among nodes */
+	crc = crc32c(crc, &flags, sizeof(flags));
+
+	return crc32c(crc, addr, ETH_ALEN);
+}
+
+/**
+ * batadv_tt_local_crc_sync() - update the VLAN CRC for a local client
+ * @tt_local: the local client which may have changed
+ *
+ * Recompute the contribution of @tt_local to the CRC of its VLAN and fold the
+ * difference into &batadv_vlan_tt.crc_sum. Not yet committed clients and
+ * clients no longer in the local table do not contribute.
+ */
+static void batadv_tt_local_crc_sync(struct batadv_tt_local_entry *tt_local)
+{
+	struct batadv_tt_common_entry *common = &tt_local->common;
+	u32 crc = 0, old_crc;
+
+	if (!hlist_unhashed(&common->hash_entry) &&
+	    !(common->flags & BATADV_TT_CLIENT_NEW))
+		crc = batadv_tt_entry_crc(common->vid,
+					  common->flags & BATADV_TT_SYNC_MASK,
+					  common->addr);
+
+	old_crc = xchg(&tt_local->crc, crc);
+	if (old_crc != crc)
+		atomic_xor(old_crc ^ crc, &tt_local->vlan->tt.crc_sum);
+}
+
+/**
+ * batadv_tt_global_crc_set() - set the VLAN CRC contribution of an orig entry
+ * @tt_global: the global entry @orig_entry belongs to
+ * @orig_entry: the orig entry to update
+ * @crc: the new contribution of @orig_entry
+ *
+ * Caller must hold tt_global->list_lock.
+ */
+static void
+batadv_tt_global_crc_set(struct batadv_tt_global_entry *tt_global,
+			 struct batadv_tt_orig_list_entry *orig_entry, u32 crc)
+{
+	struct batadv_orig_node_vlan *vlan;
+
+	lockdep_assert_held(&tt_global->list_lock);
+
+	if (orig_entry->crc == crc)
+		return;
+
+	vlan = batadv_orig_node_vlan_get(orig_entry->orig_node,
+					 tt_global->common.vid);
+	if (vlan) {
+		atomic_xor(orig_entry->crc ^ crc, &vlan->tt.crc_sum);
+		batadv_orig_node_vlan_put(vlan);
 	}
-	rcu_read_unlock();
 
-	return tt_tmp;
+	orig_entry->crc = crc;
+}
+
+/**
+ * batadv_tt_global_crc_sync() - update the VLAN CRC for an orig entry
+ * @tt_global: the global entry @orig_entry belongs to
+ * @orig_entry: the orig entry which may have changed
+ *
+ * Roaming and temporary clients as well as orig entries which are no longer
+ * part of the orig_list do not contribute to the CRC.
+ *
+ * Caller must hold tt_global->list_lock.
+ */
+static void
+batadv_tt_global_crc_sync(struct batadv_tt_global_entry *tt_global,
+			  struct batadv_tt_orig_list_entry *orig_entry)
+{
+	struct batadv_tt_common_entry *common = &tt_global->common;
+	u32 crc = 0;
+
+	if (!hlist_unhashed(&orig_entry->list) &&
+	    !(common->flags & (BATADV_TT_CLIENT_ROAM | BATADV_TT_CLIENT_TEMP)))
+		crc = batadv_tt_entry_crc(common->vid, orig_entry->flags,
+					  common->addr);
+
+	batadv_tt_global_crc_set(tt_global, orig_entry, crc);
+}
+
+/**
+ * batadv_tt_global_crc_sync_all() - update the VLAN CRCs for a global entry
+ * @tt_global: the global entry which flags may have changed
+ */
+static void
+batadv_tt_global_crc_sync_all(struct batadv_tt_global_entry *tt_global)
+{
+	struct batadv_tt_orig_list_entry *orig_entry;
+
+	spin_lock_bh(&tt_global->list_lock);
+	hlist_for_each_entry(orig_entry, &tt_global->orig_list, list)
+		batadv_tt_global_crc_sync(tt_global, orig_entry);
+	spin_unlock_bh(&tt_global->list_lock);
+}
+
+/**
+ * batadv_tt_global_crc_clear() - drop the VLAN CRC contributions of a global
+ *  entry which has been removed from the global table
+ * @tt_global: the removed global entry
+ */
+static void
+batadv_tt_global_crc_clear(struct batadv_tt_global_entry *tt_global)
+{
+	struct batadv_tt_orig_list_entry *orig_entry;
+
+	spin_lock_bh(&tt_global->list_lock);
+	hlist_for_each_entry(orig_entry, &tt_global->orig_list, list)
+		batadv_tt_global_crc_set(tt_global, orig_entry, 0);
+	spin_unlock_bh(&tt_global->list_lock);
 }
 
 /**
@@ -187,7 +367,8 @@ batadv_tt_local_hash_find(struct batadv_priv *bat_priv, const u8 *addr,
 	struct batadv_tt_common_entry *tt_common_entry;
 	struct batadv_tt_local_entry *tt_local_entry = NULL;
 
-	tt_common_entry = batadv_tt_hash_find(bat_priv->tt.local_hash, addr,
+	tt_common_entry = batadv_tt_hash_find(bat_priv->tt.local_hash,
+					      &bat_priv->tt.local_index, addr,
 					      vid);
 	if (tt_common_entry)
 		tt_local_entry = container_of(tt_common_entry,
@@ -212,7 +393,8 @@ batadv_tt_global_hash_find(struct batadv_priv *bat_priv, const u8 *addr,
 	struct batadv_tt_common_entry *tt_common_entry;
 	struct batadv_tt_global_entry *tt_global_entry = NULL;
 
-	tt_common_entry = batadv_tt_hash_find(bat_priv->tt.global_hash, addr,
+	tt_common_entry = batadv_tt_hash_find(bat_priv->tt.global_hash,
+					      &bat_priv->tt.global_index, addr,
 					      vid);
 	if (tt_common_entry)
 		tt_global_entry = container_of(tt_common_entry,
@@ -598,6 +780,8 @@ static int batadv_tt_local_table_transmit_size(struct batadv_priv *bat_priv)
 
 static int batadv_tt_local_init(struct batadv_priv *bat_priv)
 {
+	int ret;
+
 	if (bat_priv->tt.local_hash)
 		return 0;
 
@@ -606,6 +790,14 @@ static int batadv_tt_local_init(struct batadv_priv *bat_priv)
 	if (!bat_priv->tt.local_hash)
 		return -ENOMEM;
 
+	ret = rhashtable_init(&bat_priv->tt.local_index,
+			      &batadv_tt_index_params);
+	if (ret < 0) {
+		batadv_hash_destroy(bat_priv->tt.local_hash);
+		bat_priv->tt.local_hash = NULL;
+		return ret;
+	}
+
 	batadv_hash_set_lock_class(bat_priv->tt.local_hash,
 				   &batadv_tt_local_hash_lock_class_key);
 
@@ -621,8 +813,12 @@ static void batadv_tt_global_free(struct batadv_priv *bat_priv,
 		   tt_global->common.addr,
 		   batadv_print_vid(tt_global->common.vid), message);
 
-	batadv_hash_remove(bat_priv->tt.global_hash, batadv_compare_tt,
-			   batadv_choose_tt, &tt_global->common);
+	if (batadv_hash_remove(bat_priv->tt.global_hash, batadv_compare_tt,
+			       batadv_choose_tt, &tt_global->common))
+		rhashtable_remove_fast(&bat_priv->tt.global_index,
+				       &tt_global->common.hash_node,
+				       batadv_tt_index_params);
+	batadv_tt_global_crc_clear(tt_global);
 	batadv_tt_global_entry_put(tt_global);
 }
 
@@ -742,6 +938,7 @@ bool batadv_tt_local_add(struct net_device *soft_iface, const u8 *addr,
 	tt_local->last_seen = jiffies;
 	tt_local->common.added_at = tt_local->last_seen;
 	tt_local->vlan = vlan;
+	tt_local->crc = 0;
 
 	/* the batman interface mac and multicast addresses should never be
 	 * purged
@@ -751,9 +948,9 @@ bool batadv_tt_local_add(struct net_device *soft_iface, const u8 *addr,
 		tt_local->common.flags |= BATADV_TT_CLIENT_NOPURGE;
 
 	kref_get(&tt_local->common.refcount);
-	hash_added = batadv_hash_add(bat_priv->tt.local_hash, batadv_compare_tt,
-				     batadv_choose_tt, &tt_local->common,
-				     &tt_local->common.hash_entry);
+	hash_added = batadv_tt_hash_add(bat_priv->tt.local_hash,
+					&bat_priv->tt.local_index,
+					&tt_local->common);
 
 	if (unlikely(hash_added != 0)) {
 		/* remove the reference for the hash */
@@ -788,6 +985,7 @@ bool batadv_tt_local_add(struct net_device *soft_iface, const u8 *addr,
 			 */
 			tt_global->common.flags |= BATADV_TT_CLIENT_ROAM;
 			tt_global->roam_at = jiffies;
+			batadv_tt_global_crc_sync_all(tt_global);
 		}
 	}
 
@@ -812,6 +1010,8 @@ bool batadv_tt_local_add(struct net_device *soft_iface, const u8 *addr,
 	else
 		tt_local->common.flags &= ~BATADV_TT_CLIENT_ISOLA;
 
+	batadv_tt_local_crc_sync(tt_local);
+
 	/* if any "dynamic" flag has been modified, resend an ADD event for this
 	 * entry so that all the nodes can get the new flags
 	 */
@@ -1370,6 +1570,11 @@ u16 batadv_tt_local_remove(struct batadv_priv *bat_priv, const u8 *addr,
 	if (!tt_entry_exists)
 		goto out;
 
+	rhashtable_remove_fast(&bat_priv->tt.local_index,
+			       &tt_local_entry->common.hash_node,
+			       batadv_tt_index_params);
+	batadv_tt_local_crc_sync(tt_local_entry);
+
 	/* extra call to free the local tt entry */
 	batadv_tt_local_entry_put(tt_local_entry);
 
@@ -1472,12 +1677,15 @@ static void batadv_tt_local_table_free(struct batadv_priv *bat_priv)
 	}
 
 	batadv_hash_destroy(hash);
+	rhashtable_destroy(&bat_priv->tt.local_index);
 
 	bat_priv->tt.local_hash = NULL;
 }
 
 static int batadv_tt_global_init(struct batadv_priv *bat_priv)
 {
+	int ret;
+
 	if (bat_priv->tt.global_hash)
 		return 0;
 
@@ -1486,6 +1694,14 @@ static int batadv_tt_global_init(struct batadv_priv *bat_priv)
 	if (!bat_priv->tt.global_hash)
 		return -ENOMEM;
 
+	ret = rhashtable_init(&bat_priv->tt.global_index,
+			      &batadv_tt_index_params);
+	if (ret < 0) {
+		batadv_hash_destroy(bat_priv->tt.global_hash);
+		bat_priv->tt.global_hash = NULL;
+		return ret;
+	}
+
 	batadv_hash_set_lock_class(bat_priv->tt.global_hash,
 				   &batadv_tt_global_hash_lock_class_key);
 
@@ -1620,6 +1836,10 @@ batadv_tt_global_orig_entry_add(struct batadv_tt_global_entry *tt_global,
 		 */
 		orig_entry->ttvn = ttvn;
 		orig_entry->flags = flags;
+
+		spin_lock_bh(&tt_global->list_lock);
+		batadv_tt_global_crc_sync(tt_global, orig_entry);
+		spin_unlock_bh(&tt_global->list_lock);
 		goto sync_flags;
 	}
 
@@ -1639,6 +1859,7 @@ batadv_tt_global_orig_entry_add(struct batadv_tt_global_entry *tt_global,
 	kref_get(&orig_entry->refcount);
 	hlist_add_head_rcu(&orig_entry->list,
 			   &tt_global->orig_list);
+	batadv_tt_global_crc_sync(tt_global, orig_entry);
 	spin_unlock_bh(&tt_global->list_lock);
 	atomic_inc(&tt_global->orig_list_count);
 
@@ -1723,10 +1944,9 @@ static bool batadv_tt_global_add(struct batadv_priv *bat_priv,
 		spin_lock_init(&tt_global_entry->list_lock);
 
 		kref_get(&common->refcount);
-		hash_added = batadv_hash_add(bat_priv->tt.global_hash,
-					     batadv_compare_tt,
-					     batadv_choose_tt, common,
-					     &common->hash_entry);
+		hash_added = batadv_tt_hash_add(bat_priv->tt.global_hash,
+						&bat_priv->tt.global_index,
+						common);
 
 		if (unlikely(hash_added != 0)) {
 			/* remove the reference for the hash */
@@ -1816,6 +2036,8 @@ static bool batadv_tt_global_add(struct batadv_priv *bat_priv,
 		 */
 		tt_global_entry->common.flags &= ~BATADV_TT_CLIENT_ROAM;
 
+	batadv_tt_global_crc_sync_all(tt_global_entry);
+
 out:
 	if (tt_global_entry)
 		batadv_tt_global_entry_put(tt_global_entry);
@@ -2232,13 +2454,15 @@ _batadv_tt_global_del_orig_entry(struct batadv_tt_global_entry *tt_global_entry,
 {
 	lockdep_assert_held(&tt_global_entry->list_lock);
 
-	batadv_tt_global_size_dec(orig_entry->orig_node,
-				  tt_global_entry->common.vid);
-	atomic_dec(&tt_global_entry->orig_list_count);
 	/* requires holding tt_global_entry->list_lock and orig_entry->list
 	 * being part of a list
 	 */
-	hlist_del_rcu(&orig_entry->list);
+	hlist_del_init_rcu(&orig_entry->list);
+	batadv_tt_global_crc_sync(tt_global_entry, orig_entry);
+
+	batadv_tt_global_size_dec(orig_entry->orig_node,
+				  tt_global_entry->common.vid);
+	atomic_dec(&tt_global_entry->orig_list_count);
 	batadv_tt_orig_list_entry_put(orig_entry);
 }
 
@@ -2327,6 +2551,7 @@ batadv_tt_global_del_roaming(struct batadv_priv *bat_priv,
 		/* its the last one, mark for roaming. */
 		tt_global_entry->common.flags |= BATADV_TT_CLIENT_ROAM;
 		tt_global_entry->roam_at = jiffies;
+		batadv_tt_global_crc_sync_all(tt_global_entry);
 	} else {
 		/* there is another entry, we can simply delete this
 		 * one and can still use the other one.
@@ -2452,7 +2677,8 @@ void batadv_tt_global_del_orig(struct batadv_priv *bat_priv,
 					   "Deleting global tt entry %pM (vid: %d): %s\n",
 					   tt_global->common.addr,
 					   batadv_print_vid(vid), message);
-				hlist_del_rcu(&tt_common_entry->hash_entry);
+				batadv_tt_hash_unlink(&bat_priv->tt.global_index,
+						      tt_common_entry);
 				batadv_tt_global_entry_put(tt_global);
 			}
 		}
@@ -2514,7 +2740,8 @@ static void batadv_tt_global_purge(struct batadv_priv *bat_priv)
 				   batadv_print_vid(tt_global->common.vid),
 				   msg);
 
-			hlist_del_rcu(&tt_common->hash_entry);
+			batadv_tt_hash_unlink(&bat_priv->tt.global_index,
+					      tt_common);
 
 			batadv_tt_global_entry_put(tt_global);
 		}
@@ -2554,6 +2781,7 @@ static void batadv_tt_global_table_free(struct batadv_priv *bat_priv)
 	}
 
 	batadv_hash_destroy(hash);
+	rhashtable_destroy(&bat_priv->tt.global_index);
 
 	bat_priv->tt.global_hash = NULL;
 }
@@ -2667,9 +2895,7 @@ static u32 batadv_tt_global_crc(struct batadv_priv *bat_priv,
 	struct batadv_tt_common_entry *tt_common;
 	struct batadv_tt_global_entry *tt_global;
 	struct hlist_head *head;
-	u32 i, crc_tmp, crc = 0;
-	u8 flags;
-	__be16 tmp_vid;
+	u32 i, crc = 0;
 
 	for (i = 0; i < hash->size; i++) {
 		head = &hash->table[i];
@@ -2707,19 +2933,9 @@ static u32 batadv_tt_global_crc(struct batadv_priv *bat_priv,
 			if (!tt_orig)
 				continue;
 
-			/* use network order to read the VID: this ensures that
-			 * every node reads the bytes in the same order.
-			 */
-			tmp_vid = htons(tt_common->vid);
-			crc_tmp = crc32c(0, &tmp_vid, sizeof(tmp_vid));
-
-			/* compute the CRC on flags that have to be kept in sync
-			 * among nodes
-			 */
-			flags = tt_orig->flags;
-			crc_tmp = crc32c(crc_tmp, &flags, sizeof(flags));
-
-			crc ^= crc32c(crc_tmp, tt_common->addr, ETH_ALEN);
+			crc ^= batadv_tt_entry_crc(tt_common->vid,
+						   tt_orig->flags,
+						   tt_common->addr);
 
 			batadv_tt_orig_list_entry_put(tt_orig);
 		}
@@ -2729,63 +2945,6 @@ static u32 batadv_tt_global_crc(struct batadv_priv *bat_priv,
 	return crc;
 }
 
-/**
- * batadv_tt_local_crc() - calculates the checksum of the local table
- * @bat_priv: the bat priv with all the soft interface information
- * @vid: VLAN identifier for which the CRC32 has to be computed
- *
- * For details about the computation, please refer to the documentation for
- * batadv_tt_global_crc().
- *
- * Return: the checksum of the local table
- */
-static u32 batadv_tt_local_crc(struct batadv_priv *bat_priv,
-			       unsigned short vid)
-{
-	struct batadv_hashtable *hash = bat_priv->tt.local_hash;
-	struct batadv_tt_common_entry *tt_common;
-	struct hlist_head *head;
-	u32 i, crc_tmp, crc = 0;
-	u8 flags;
-	__be16 tmp_vid;
-
-	for (i = 0; i < hash->size; i++) {
-		head = &hash->table[i];
-
-		rcu_read_lock();
-		hlist_for_each_entry_rcu(tt_common, head, hash_entry) {
-			/* compute the CRC only for entries belonging to the
-			 * VLAN identified by vid
-			 */
-			if (tt_common->vid != vid)
-				continue;
-
-			/* not yet committed clients have not to be taken into
-			 * account while computing the CRC
-			 */
-			if (tt_common->flags & BATADV_TT_CLIENT_NEW)
-				continue;
-
-			/* use network order to read the VID: this ensures that
-			 * every node reads the bytes in the same order.
-			 */
-			tmp_vid = htons(tt_common->vid);
-			crc_tmp = crc32c(0, &tmp_vid, sizeof(tmp_vid));
-
-			/* compute the CRC on flags that have to be kept in sync
-			 * among nodes
-			 */
-			flags = tt_common->flags & BATADV_TT_SYNC_MASK;
-			crc_tmp = crc32c(crc_tmp, &flags, sizeof(flags));
-
-			crc ^= crc32c(crc_tmp, tt_common->addr, ETH_ALEN);
-		}
-		rcu_read_unlock();
-	}
-
-	return crc;
-}
-
 /**
  * batadv_tt_req_node_release() - free tt_req node entry
  * @ref: kref pointer of the tt req_node entry
@@ -3082,10 +3241,10 @@ static void batadv_tt_local_update_crc(struct batadv_priv *bat_priv)
 {
 	struct batadv_softif_vlan *vlan;
 
-	/* recompute the global CRC for each VLAN */
+	/* the CRC of each VLAN is kept up to date on every client change */
 	rcu_read_lock();
 	hlist_for_each_entry_rcu(vlan, &bat_priv->softif_vlan_list, list) {
-		vlan->tt.crc = batadv_tt_local_crc(bat_priv, vlan->vid);
+		vlan->tt.crc = atomic_read(&vlan->tt.crc_sum);
 	}
 	rcu_read_unlock();
 }
@@ -3099,9 +3258,8 @@ static void batadv_tt_global_update_crc(struct batadv_priv *bat_priv,
 					struct batadv_orig_node *orig_node)
 {
 	struct batadv_orig_node_vlan *vlan;
-	u32 crc;
 
-	/* recompute the global CRC for each VLAN */
+	/* the CRC of each VLAN is kept up to date on every client change */
 	rcu_read_lock();
 	hlist_for_each_entry_rcu(vlan, &orig_node->vlan_list, list) {
 		/* if orig_node is a backbone node for this VLAN, don't compute
@@ -3111,10 +3269,51 @@ static void batadv_tt_global_update_crc(struct batadv_priv *bat_priv,
 						   vlan->vid))
 			continue;
 
+		vlan->tt.crc = atomic_read(&vlan->tt.crc_sum);
+	}
+	rcu_read_unlock();
+}
+
+/**
+ * batadv_tt_global_resync_crc() - recompute all the global CRCs for this
+ *  orig_node from scratch
+ * @bat_priv: the bat priv with all the soft interface information
+ * @orig_node: the orig_node for which the CRCs have to be recomputed
+ *
+ * Walks the whole global table, so this is only used when the incrementally
+ * maintained CRCs do not match the ones announced by @orig_node.
+ *
+ * Return: true if any of the CRCs changed, false otherwise
+ */
+static bool batadv_tt_global_resync_crc(struct batadv_priv *bat_priv,
+					struct batadv_orig_node *orig_node)
+{
+	struct batadv_orig_node_vlan *vlan;
+	bool changed = false;
+	u32 crc, crc_sum;
+
+	rcu_read_lock();
+	hlist_for_each_entry_rcu(vlan, &orig_node->vlan_list, list) {
+		if (batadv_bla_is_backbone_gw_orig(bat_priv, orig_node->orig,
+						   vlan->vid))
+			continue;
+
 		crc = batadv_tt_global_crc(bat_priv, orig_node, vlan->vid);
+		crc_sum = atomic_read(&vlan->tt.crc_sum);
+		if (crc == crc_sum)
+			continue;
+
+		batadv_dbg(BATADV_DBG_TT, bat_priv,
+			   "Fixing up TT CRC for %pM (vid: %d): %#.8x -> %#.8x\n",
+			   orig_node->orig, batadv_print_vid(vlan->vid),
+			   crc_sum, crc);
+		atomic_xor(crc ^ crc_sum, &vlan->tt.crc_sum);
 		vlan->tt.crc = crc;
+		changed = true;
 	}
 	rcu_read_unlock();
+
+	return changed;
 }
 
 /**
@@ -3830,6 +4029,7 @@ static void batadv_tt_local_set_flags(struct batadv_priv *bat_priv, u16 flags,
 {
 	struct batadv_hashtable *hash = bat_priv->tt.local_hash;
 	struct batadv_tt_common_entry *tt_common_entry;
+	struct batadv_tt_local_entry *tt_local;
 	struct hlist_head *head;
 	u32 i;
 
@@ -3852,6 +4052,11 @@ static void batadv_tt_local_set_flags(struct batadv_priv *bat_priv, u16 flags,
 				tt_common_entry->flags &= ~flags;
 			}
 
+			tt_local = container_of(tt_common_entry,
+						struct batadv_tt_local_entry,
+						common);
+			batadv_tt_local_crc_sync(tt_local);
+
 			if (!count)
 				continue;
 
@@ -3892,10 +4097,12 @@ static void batadv_tt_local_purge_pending_clients(struct batadv_priv *bat_priv)
 				   batadv_print_vid(tt_common->vid));
 
 			batadv_tt_local_size_dec(bat_priv, tt_common->vid);
-			hlist_del_rcu(&tt_common->hash_entry);
+			batadv_tt_hash_unlink(&bat_priv->tt.local_index,
+					      tt_common);
 			tt_local = container_of(tt_common,
 						struct batadv_tt_local_entry,
 						common);
+			batadv_tt_local_crc_sync(tt_local);
 
 			batadv_tt_local_entry_put(tt_local);
 		}
@@ -4037,11 +4244,18 @@ static void batadv_tt_update_orig(struct batadv_priv *bat_priv,
 					 ttvn, tt_change);
 
 		/* Even if we received the precomputed crc with the OGM, we
-		 * prefer to recompute it to spot any possible inconsistency
+		 * prefer to use our own to spot any possible inconsistency
 		 * in the global table
 		 */
 		batadv_tt_global_update_crc(bat_priv, orig_node);
 
+		/* before asking for the full table, make sure the mismatch is
+		 * not caused by our incrementally maintained CRCs
+		 */
+		if (!batadv_tt_global_check_crc(orig_node, tt_vlan,
+						tt_num_vlan))
+			batadv_tt_global_resync_crc(bat_priv, orig_node);
+
 		spin_unlock_bh(&orig_node->tt_lock);
 
 		/* The ttvn alone is not enough to guarantee consistency
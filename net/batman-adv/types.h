@@ -30,6 +30,7 @@
 #include <linux/kref.h>
 #include <linux/netdevice.h>
 #include <linux/netlink.h>
+#include <linux/rhashtable.h>
 #include <linux/sched.h> /* for linux/wait.h */
 #include <linux/spinlock.h>
 #include <linux/types.h>
@@ -91,6 +92,13 @@ struct batadv_hard_iface_bat_iv {
 
 	/** @ogm_seqno: OGM sequence number - used to identify each OGM */
 	atomic_t ogm_seqno;
+
+	/**
+	 * @aggr_list: queued OGM aggregates leaving on this interface which
+	 *  still have room for more OGMs, newest first (protected by
+	 *  &batadv_priv.forw_bat_list_lock)
+	 */
+	struct hlist_head aggr_list;
 };
 
 /**
@@ -308,6 +316,12 @@ struct batadv_vlan_tt {
 	/** @crc: CRC32 checksum of the entries belonging to this vlan */
 	u32 crc;
 
+	/**
+	 * @crc_sum: running XOR of the CRC32 contributions of the entries
+	 *  belonging to this vlan, updated on every change of such an entry
+	 */
+	atomic_t crc_sum;
+
 	/** @num_entries: number of TT entries for this VLAN */
 	atomic_t num_entries;
 };
@@ -379,6 +393,12 @@ struct batadv_orig_node {
 	/** @last_seen: time when last packet from this node was received */
 	unsigned long last_seen;
 
+	/**
+	 * @purge_at: time before which none of the neighbors can time out, the
+	 *  periodic purging skips the neighbor lists until then
+	 */
+	unsigned long purge_at;
+
 	/**
 	 * @bcast_seqno_reset: time when the broadcast seqno window was reset
 	 */
@@ -472,6 +492,9 @@ struct batadv_orig_node {
 	/** @hash_entry: hlist node for &batadv_priv.orig_hash */
 	struct hlist_node hash_entry;
 
+	/** @hash_node: rhashtable node for &batadv_priv.orig_index */
+	struct rhash_head hash_node;
+
 	/** @bat_priv: pointer to soft_iface this orig node belongs to */
 	struct batadv_priv *bat_priv;
 
@@ -793,6 +816,15 @@ enum batadv_counters {
 	 */
 	BATADV_CNT_MGMT_RX_BYTES,
 
+	/** @BATADV_CNT_OGM_AGGR: queued OGMv1 aggregate packet counter */
+	BATADV_CNT_OGM_AGGR,
+
+	/**
+	 * @BATADV_CNT_OGM_AGGR_OGMS: OGMv1 counter for OGMs queued into
+	 *  aggregate packets
+	 */
+	BATADV_CNT_OGM_AGGR_OGMS,
+
 	/** @BATADV_CNT_FRAG_TX: transmitted fragment traffic packet counter */
 	BATADV_CNT_FRAG_TX,
 
@@ -956,6 +988,12 @@ struct batadv_priv_tt {
 	/** @global_hash: global translation table hash table */
 	struct batadv_hashtable *global_hash;
 
+	/** @local_index: resizable lookup index for @local_hash */
+	struct rhashtable local_index;
+
+	/** @global_index: resizable lookup index for @global_hash */
+	struct rhashtable global_index;
+
 	/** @req_list: list of pending & unanswered tt_requests */
 	struct hlist_head req_list;
 
@@ -1623,6 +1661,9 @@ struct batadv_priv {
 	/** @tp_num: number of currently active tp sessions */
 	struct batadv_hashtable *orig_hash;
 
+	/** @orig_index: resizable lookup index for @orig_hash */
+	struct rhashtable orig_index;
+
 	/** @orig_hash: hash table containing mesh participants (orig nodes) */
 	spinlock_t forw_bat_list_lock;
 
@@ -1638,6 +1679,15 @@ struct batadv_priv {
 	/** @orig_work: work queue callback item for orig node purging */
 	struct delayed_work orig_work;
 
+	/** @orig_purge_slice: part of orig_hash purged by the next orig_work */
+	u32 orig_purge_slice;
+
+	/**
+	 * @orig_purge_iface_down: a hard interface was deactivated, the next
+	 *  orig_work has to purge the whole orig_hash
+	 */
+	atomic_t orig_purge_iface_down;
+
 	/**
 	 * @primary_if: one of the hard-interfaces assigned to this mesh
 	 *  interface becomes the primary interface
@@ -1840,6 +1890,12 @@ struct batadv_tt_common_entry {
 	 */
 	struct hlist_node hash_entry;
 
+	/**
+	 * @hash_node: rhashtable node for &batadv_priv_tt.local_index or for
+	 *  &batadv_priv_tt.global_index
+	 */
+	struct rhash_head hash_node;
+
 	/** @flags: various state handling flags (see batadv_tt_client_flags) */
 	u16 flags;
 
@@ -1865,6 +1921,9 @@ struct batadv_tt_local_entry {
 
 	/** @vlan: soft-interface vlan of the entry */
 	struct batadv_softif_vlan *vlan;
+
+	/** @crc: contribution of this entry to the crc_sum of @vlan */
+	u32 crc;
 };
 
 /**
@@ -1903,6 +1962,12 @@ struct batadv_tt_orig_list_entry {
 	/** @flags: per orig entry TT sync flags */
 	u8 flags;
 
+	/**
+	 * @crc: contribution of this entry to the crc_sum of the orig_node
+	 *  VLAN, protected by &batadv_tt_global_entry.list_lock
+	 */
+	u32 crc;
+
 	/** @list: list node for &batadv_tt_global_entry.orig_list */
 	struct hlist_node list;
 
@@ -2069,6 +2134,12 @@ struct batadv_forw_packet {
 	 */
 	struct hlist_node list;
 
+	/**
+	 * @aggr_list: list node for &batadv_hard_iface_bat_iv.aggr_list of the
+	 *  outgoing interface
+	 */
+	struct hlist_node aggr_list;
+
 	/** @cleanup_list: list node for purging functions */
 	struct hlist_node cleanup_list;
 
@@ -591,7 +591,7 @@ void br_fdb_update(struct net_bridge *br, struct net_bridge_port *source,
 				if (unlikely(fdb->added_by_external_learn))
 					fdb->added_by_external_learn = 0;
 			}
-			if (now != fdb->updated)
+			if (br_fdb_stamp_stale(source, fdb->updated, now))
 				fdb->updated = now;
 			if (unlikely(added_by_user))
 				fdb->added_by_user = 1;
@@ -259,16 +259,26 @@ static void maybe_deliver_addr(struct net_bridge_port *p, struct sk_buff *skb,
 	if (skb->dev == p->dev && ether_addr_equal(src, addr))
 		return;
 
-	skb = skb_copy(skb, GFP_ATOMIC);
-	if (!skb) {
-		dev->stats.tx_dropped++;
-		return;
-	}
+	skb = skb_clone(skb, GFP_ATOMIC);
+	if (!skb)
+		goto drop;
 
-	if (!is_broadcast_ether_addr(addr))
+	/* only the destination address differs per receiver, so unshare
+	 * just the linear header and keep the paged payload shared
+	 */
+	if (!is_broadcast_ether_addr(addr)) {
+		if (skb_cow_head(skb, 0)) {
+			kfree_skb(skb);
+			goto drop;
+		}
 		memcpy(eth_hdr(skb)->h_dest, addr, ETH_ALEN);
+	}
 
 	__br_forward(p, skb, local_orig);
+	return;
+
+drop:
+	dev->stats.tx_dropped++;
 }
 
 /* called with rcu_read_lock */
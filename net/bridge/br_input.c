@@ -161,7 +161,7 @@ int br_handle_frame_finish(struct net *net, struct sock *sk, struct sk_buff *skb
 		if (dst->is_local)
 			return br_pass_frame_up(skb);
 
-		if (now != dst->used)
+		if (br_fdb_stamp_stale(dst->dst, dst->used, now))
 			dst->used = now;
 		br_forward(dst->dst, skb, local_rcv, false);
 	} else {
@@ -28,6 +28,9 @@
 
 #define BR_HOLD_TIME (1*HZ)
 
+/* granularity of fdb timestamps on ports in lazy update mode */
+#define BR_FDB_LAZY_INTERVAL (1*HZ)
+
 #define BR_PORT_BITS	10
 #define BR_MAX_PORTS	(1<<BR_PORT_BITS)
 
@@ -566,6 +569,18 @@ int br_fdb_external_learn_del(struct net_bridge *br, struct net_bridge_port *p,
 void br_fdb_offloaded_set(struct net_bridge *br, struct net_bridge_port *p,
 			  const unsigned char *addr, u16 vid);
 
+/* Writing a timestamp dirties the cache line of a shared fdb entry, ports in
+ * lazy update mode only refresh it when it lags by more than the interval.
+ */
+static inline bool br_fdb_stamp_stale(const struct net_bridge_port *p,
+				      unsigned long stamp, unsigned long now)
+{
+	if (p && (p->flags & BR_FDB_LAZY_UPDATE))
+		return time_after(now, stamp + BR_FDB_LAZY_INTERVAL);
+
+	return now != stamp;
+}
+
 /* br_forward.c */
 enum br_pkt_type {
 	BR_PKT_UNICAST,
@@ -71,10 +71,6 @@ static struct page *__page_pool_get_cached(struct page_pool *pool)
 	struct ptr_ring *r = &pool->ring;
 	struct page *page;
 
-	/* Quicker fallback, avoid locks when ring is empty */
-	if (__ptr_ring_empty(r))
-		return NULL;
-
 	/* Test for safe-context, caller should provide this guarantee */
 	if (likely(in_serving_softirq())) {
 		if (likely(pool->alloc.count)) {
@@ -82,6 +78,11 @@ static struct page *__page_pool_get_cached(struct page_pool *pool)
 			page = pool->alloc.cache[--pool->alloc.count];
 			return page;
 		}
+
+		/* Quicker fallback, avoid locks when ring is empty */
+		if (__ptr_ring_empty(r))
+			return NULL;
+
 		/* Slower-path: Alloc array empty, time to refill
 		 *
 		 * Open-coded bulk ptr_ring consumer.
@@ -51,7 +51,7 @@ static void ieee80211_free_tid_rx(struct rcu_head *h)
 		container_of(h, struct tid_ampdu_rx, rcu_head);
 	int i;
 
-	for (i = 0; i < tid_rx->buf_size; i++)
+	for_each_set_bit(i, tid_rx->reorder_buf_busy, tid_rx->buf_size)
 		__skb_queue_purge(&tid_rx->reorder_buf[i]);
 	kfree(tid_rx->reorder_buf);
 	kfree(tid_rx->reorder_time);
@@ -393,6 +393,7 @@ void ___ieee80211_start_rx_ba_session(struct sta_info *sta,
 	tid_agg_rx->auto_seq = auto_seq;
 	tid_agg_rx->started = false;
 	tid_agg_rx->reorder_buf_filtered = 0;
+	bitmap_zero(tid_agg_rx->reorder_buf_busy, IEEE80211_MAX_AMPDU_BUF);
 	tid_agg_rx->tid = tid;
 	tid_agg_rx->sta = sta;
 	status = WLAN_STATUS_SUCCESS;
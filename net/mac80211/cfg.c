@@ -907,6 +907,9 @@ static int ieee80211_start_ap(struct wiphy *wiphy, struct net_device *dev,
 	}
 	sdata->u.ap.req_smps = sdata->smps_mode;
 
+	sdata->u.ap.probe_resp_window = jiffies;
+	sdata->u.ap.probe_resp_count = 0;
+
 	sdata->needed_rx_chains = sdata->local->rx_chains;
 
 	sdata->vif.bss_conf.beacon_int = params->beacon_interval;
@@ -266,6 +266,10 @@ struct beacon_data {
 	struct rcu_head rcu_head;
 };
 
+/* probe responses mac80211 sends per AP interface and window */
+#define IEEE80211_AP_PROBE_RESP_LIMIT	64
+#define IEEE80211_AP_PROBE_RESP_WINDOW	(HZ / 10)
+
 struct probe_resp {
 	struct rcu_head rcu_head;
 	int len;
@@ -300,6 +304,10 @@ struct ieee80211_if_ap {
 
 	struct work_struct request_smps_work;
 	bool multicast_to_unicast;
+
+	/* rate limit of probe responses sent by mac80211 */
+	unsigned long probe_resp_window;
+	unsigned int probe_resp_count;
 };
 
 struct ieee80211_if_wds {
@@ -1151,6 +1159,9 @@ struct ieee80211_local {
 
 	bool use_chanctx;
 
+	/* probe requests on AP interfaces are answered by mac80211 */
+	bool sw_probe_resp;
+
 	/* protects the aggregated multicast list and filter calls */
 	spinlock_t filter_lock;
 
@@ -34,6 +34,11 @@
 #include "led.h"
 #include "debugfs.h"
 
+static bool sw_probe_resp_offload;
+module_param(sw_probe_resp_offload, bool, 0444);
+MODULE_PARM_DESC(sw_probe_resp_offload,
+		 "Answer probe requests on AP interfaces from the probe response template");
+
 void ieee80211_configure_filter(struct ieee80211_local *local)
 {
 	u64 mc;
@@ -1000,6 +1005,24 @@ int ieee80211_register_hw(struct ieee80211_hw *hw)
 	/* mac80211 supports control port protocol changing */
 	local->hw.wiphy->flags |= WIPHY_FLAG_CONTROL_PORT_PROTOCOL;
 
+	/*
+	 * If the device doesn't answer probe requests by itself, mac80211
+	 * can do it from the template userspace provides with the offload.
+	 * WPS, P2P and interworking requests are still passed to userspace,
+	 * so those protocols keep working with the offload enabled.
+	 */
+	if (sw_probe_resp_offload &&
+	    (local->hw.wiphy->interface_modes & BIT(NL80211_IFTYPE_AP)) &&
+	    !(local->hw.wiphy->flags & WIPHY_FLAG_AP_PROBE_RESP_OFFLOAD)) {
+		local->hw.wiphy->flags |= WIPHY_FLAG_AP_PROBE_RESP_OFFLOAD;
+		local->hw.wiphy->probe_resp_offload =
+			NL80211_PROBE_RESP_OFFLOAD_SUPPORT_WPS |
+			NL80211_PROBE_RESP_OFFLOAD_SUPPORT_WPS2 |
+			NL80211_PROBE_RESP_OFFLOAD_SUPPORT_P2P |
+			NL80211_PROBE_RESP_OFFLOAD_SUPPORT_80211U;
+		local->sw_probe_resp = true;
+	}
+
 	if (ieee80211_hw_check(&local->hw, SIGNAL_DBM)) {
 		local->hw.wiphy->signal_type = CFG80211_SIGNAL_TYPE_MBM;
 	} else if (ieee80211_hw_check(&local->hw, SIGNAL_UNSPEC)) {
@@ -1032,7 +1032,7 @@ static inline bool ieee80211_rx_reorder_ready(struct tid_ampdu_rx *tid_agg_rx,
 	if (tid_agg_rx->reorder_buf_filtered & BIT_ULL(index))
 		return true;
 
-	if (!tail)
+	if (!test_bit(index, tid_agg_rx->reorder_buf_busy) || !tail)
 		return false;
 
 	status = IEEE80211_SKB_RXCB(tail);
@@ -1070,20 +1070,79 @@ static void ieee80211_release_reorder_frame(struct ieee80211_sub_if_data *sdata,
 	}
 
 no_frame:
+	__clear_bit(index, tid_agg_rx->reorder_buf_busy);
 	tid_agg_rx->reorder_buf_filtered &= ~BIT_ULL(index);
 	tid_agg_rx->head_seq_num = ieee80211_sn_inc(tid_agg_rx->head_seq_num);
 }
 
+int ieee80211_reorder_next_busy(const unsigned long *busy, int size,
+				int index)
+{
+	int next;
+
+	next = find_next_bit(busy, size, index);
+	if (next < size)
+		return next - index;
+
+	next = find_first_bit(busy, index);
+	if (next < index)
+		return next + size - index;
+
+	return size;
+}
+EXPORT_SYMBOL(ieee80211_reorder_next_busy);
+
+u16 ieee80211_reorder_skip_empty(const unsigned long *busy, int size,
+				 u16 head, u16 limit)
+{
+	int skip;
+
+	skip = ieee80211_reorder_next_busy(busy, size, head % size);
+	skip = min_t(int, skip, ieee80211_sn_sub(limit, head));
+
+	return ieee80211_sn_add(head, skip);
+}
+EXPORT_SYMBOL(ieee80211_reorder_skip_empty);
+
+/*
+ * Return the distance from @index to the next reorder buffer slot that may
+ * need attention when releasing frames, or buf_size if there is none.
+ * Filtered frames are rare, just walk slot by slot while any are marked.
+ */
+static int ieee80211_reorder_next_slot(struct tid_ampdu_rx *tid_agg_rx,
+				       int index)
+{
+	if (tid_agg_rx->reorder_buf_filtered)
+		return 0;
+
+	return ieee80211_reorder_next_busy(tid_agg_rx->reorder_buf_busy,
+					   tid_agg_rx->buf_size, index);
+}
+
 static void ieee80211_release_reorder_frames(struct ieee80211_sub_if_data *sdata,
 					     struct tid_ampdu_rx *tid_agg_rx,
 					     u16 head_seq_num,
 					     struct sk_buff_head *frames)
 {
 	int index;
+	u16 head;
 
 	lockdep_assert_held(&tid_agg_rx->reorder_lock);
 
 	while (ieee80211_sn_less(tid_agg_rx->head_seq_num, head_seq_num)) {
+		/* advance over a run of empty slots in one go */
+		if (!tid_agg_rx->reorder_buf_filtered) {
+			head = ieee80211_reorder_skip_empty(
+					tid_agg_rx->reorder_buf_busy,
+					tid_agg_rx->buf_size,
+					tid_agg_rx->head_seq_num,
+					head_seq_num);
+			if (head != tid_agg_rx->head_seq_num) {
+				tid_agg_rx->head_seq_num = head;
+				continue;
+			}
+		}
+
 		index = tid_agg_rx->head_seq_num % tid_agg_rx->buf_size;
 		ieee80211_release_reorder_frame(sdata, tid_agg_rx, index,
 						frames);
@@ -1105,12 +1164,13 @@ static void ieee80211_sta_reorder_release(struct ieee80211_sub_if_data *sdata,
 					  struct tid_ampdu_rx *tid_agg_rx,
 					  struct sk_buff_head *frames)
 {
-	int index, i, j;
+	int size = tid_agg_rx->buf_size;
+	int index, i, j, skip;
 
 	lockdep_assert_held(&tid_agg_rx->reorder_lock);
 
 	/* release the buffer until next missing frame */
-	index = tid_agg_rx->head_seq_num % tid_agg_rx->buf_size;
+	index = tid_agg_rx->head_seq_num % size;
 	if (!ieee80211_rx_reorder_ready(tid_agg_rx, index) &&
 	    tid_agg_rx->stored_mpdu_num) {
 		/*
@@ -1118,8 +1178,14 @@ static void ieee80211_sta_reorder_release(struct ieee80211_sub_if_data *sdata,
 		 * frames in the reorder buffer have timed out.
 		 */
 		int skipped = 1;
-		for (j = (index + 1) % tid_agg_rx->buf_size; j != index;
-		     j = (j + 1) % tid_agg_rx->buf_size) {
+		for (j = (index + 1) % size; j != index; j = (j + 1) % size) {
+			/* empty slots are never ready, jump over them */
+			skip = ieee80211_reorder_next_slot(tid_agg_rx, j);
+			if (skip >= (index - j + size) % size)
+				break;
+			skipped += skip;
+			j = (j + skip) % size;
+
 			if (!ieee80211_rx_reorder_ready(tid_agg_rx, j)) {
 				skipped++;
 				continue;
@@ -1130,9 +1196,12 @@ static void ieee80211_sta_reorder_release(struct ieee80211_sub_if_data *sdata,
 				goto set_release_timer;
 
 			/* don't leave incomplete A-MSDUs around */
-			for (i = (index + 1) % tid_agg_rx->buf_size; i != j;
-			     i = (i + 1) % tid_agg_rx->buf_size)
+			for (i = (index + 1) % size; i != j; i = (i + 1) % size) {
+				if (!__test_and_clear_bit(i,
+						tid_agg_rx->reorder_buf_busy))
+					continue;
 				__skb_queue_purge(&tid_agg_rx->reorder_buf[i]);
+			}
 
 			ht_dbg_ratelimited(sdata,
 					   "release an RX reorder frame due to timeout on earlier frames\n");
@@ -1150,16 +1219,18 @@ static void ieee80211_sta_reorder_release(struct ieee80211_sub_if_data *sdata,
 	} else while (ieee80211_rx_reorder_ready(tid_agg_rx, index)) {
 		ieee80211_release_reorder_frame(sdata, tid_agg_rx, index,
 						frames);
-		index =	tid_agg_rx->head_seq_num % tid_agg_rx->buf_size;
+		index =	tid_agg_rx->head_seq_num % size;
 	}
 
 	if (tid_agg_rx->stored_mpdu_num) {
-		j = index = tid_agg_rx->head_seq_num % tid_agg_rx->buf_size;
+		j = tid_agg_rx->head_seq_num % size;
 
-		for (; j != (index - 1) % tid_agg_rx->buf_size;
-		     j = (j + 1) % tid_agg_rx->buf_size) {
+		for (i = 0; i < size; i += skip + 1) {
+			skip = ieee80211_reorder_next_slot(tid_agg_rx, j);
+			j = (j + skip) % size;
 			if (ieee80211_rx_reorder_ready(tid_agg_rx, j))
 				break;
+			j = (j + 1) % size;
 		}
 
  set_release_timer:
@@ -1263,6 +1334,7 @@ static bool ieee80211_sta_manage_reorder_buf(struct ieee80211_sub_if_data *sdata
 
 	/* put the frame in the reordering buffer */
 	__skb_queue_tail(&tid_agg_rx->reorder_buf[index], skb);
+	__set_bit(index, tid_agg_rx->reorder_buf_busy);
 	if (!(status->flag & RX_FLAG_AMSDU_MORE)) {
 		tid_agg_rx->reorder_time[index] = jiffies;
 		tid_agg_rx->stored_mpdu_num++;
@@ -3265,6 +3337,96 @@ ieee80211_rx_h_action(struct ieee80211_rx_data *rx)
 	return RX_QUEUED;
 }
 
+static ieee80211_rx_result debug_noinline
+ieee80211_rx_h_ap_probe_req(struct ieee80211_rx_data *rx)
+{
+	struct ieee80211_sub_if_data *sdata = rx->sdata;
+	struct ieee80211_mgmt *mgmt = (void *)rx->skb->data;
+	struct ieee80211_local *local = rx->local;
+	struct ieee80211_if_ap *ap = &sdata->u.ap;
+	struct probe_resp *presp;
+	struct sk_buff *skb;
+	const u8 *ssid, *ies;
+	int ies_len;
+	u8 *pos;
+
+	if (!local->sw_probe_resp || sdata->vif.type != NL80211_IFTYPE_AP ||
+	    !ieee80211_is_probe_req(mgmt->frame_control))
+		return RX_CONTINUE;
+
+	presp = rcu_dereference(ap->probe_resp);
+	if (!presp)
+		return RX_CONTINUE;
+
+	if (!is_broadcast_ether_addr(mgmt->da) &&
+	    !ether_addr_equal(mgmt->da, sdata->vif.addr))
+		return RX_CONTINUE;
+
+	if (!is_broadcast_ether_addr(mgmt->bssid) &&
+	    !ether_addr_equal(mgmt->bssid, sdata->vif.addr))
+		return RX_CONTINUE;
+
+	/*
+	 * Only answer requests for our SSID or the wildcard SSID, and leave
+	 * everything else (hidden SSID, SSID lists, ...) to userspace.
+	 */
+	ies = mgmt->u.probe_req.variable;
+	ies_len = rx->skb->len -
+		  offsetof(struct ieee80211_mgmt, u.probe_req.variable);
+	ssid = cfg80211_find_ie(WLAN_EID_SSID, ies, ies_len);
+	if (!ssid)
+		return RX_CONTINUE;
+
+	/*
+	 * WPS, P2P and interworking requests may need an answer that differs
+	 * from the template, hostapd has to see those.
+	 */
+	if (cfg80211_find_vendor_ie(WLAN_OUI_MICROSOFT,
+				    WLAN_OUI_TYPE_MICROSOFT_WPS,
+				    ies, ies_len) ||
+	    cfg80211_find_vendor_ie(WLAN_OUI_WFA, WLAN_OUI_TYPE_WFA_P2P,
+				    ies, ies_len) ||
+	    cfg80211_find_ie(WLAN_EID_INTERWORKING, ies, ies_len))
+		return RX_CONTINUE;
+
+	if (ssid[1] == 0) {
+		if (sdata->vif.bss_conf.hidden_ssid)
+			return RX_CONTINUE;
+	} else if (ssid[1] != sdata->vif.bss_conf.ssid_len ||
+		   memcmp(ssid + 2, sdata->vif.bss_conf.ssid, ssid[1])) {
+		return RX_CONTINUE;
+	}
+
+	if (time_after(jiffies, ap->probe_resp_window +
+				IEEE80211_AP_PROBE_RESP_WINDOW)) {
+		ap->probe_resp_window = jiffies;
+		ap->probe_resp_count = 0;
+	}
+
+	/* over the limit, let userspace decide */
+	if (ap->probe_resp_count >= IEEE80211_AP_PROBE_RESP_LIMIT)
+		return RX_CONTINUE;
+
+	skb = dev_alloc_skb(local->hw.extra_tx_headroom + presp->len);
+	if (!skb)
+		return RX_CONTINUE;
+
+	skb_reserve(skb, local->hw.extra_tx_headroom);
+	pos = skb_put_data(skb, presp->data, presp->len);
+	memcpy(((struct ieee80211_mgmt *)pos)->da, mgmt->sa, ETH_ALEN);
+	IEEE80211_SKB_CB(skb)->flags |= IEEE80211_TX_INTFL_DONT_ENCRYPT;
+
+	/* avoid excessive retries for probe request to wildcard SSIDs */
+	if (ssid[1] == 0)
+		IEEE80211_SKB_CB(skb)->flags |= IEEE80211_TX_CTL_NO_ACK;
+
+	ieee80211_tx_skb(sdata, skb);
+	ap->probe_resp_count++;
+
+	dev_kfree_skb(rx->skb);
+	return RX_QUEUED;
+}
+
 static ieee80211_rx_result debug_noinline
 ieee80211_rx_h_userspace_mgmt(struct ieee80211_rx_data *rx)
 {
@@ -3567,6 +3729,7 @@ static void ieee80211_rx_handlers(struct ieee80211_rx_data *rx,
 
 		CALL_RXH(ieee80211_rx_h_mgmt_check);
 		CALL_RXH(ieee80211_rx_h_action);
+		CALL_RXH(ieee80211_rx_h_ap_probe_req);
 		CALL_RXH(ieee80211_rx_h_userspace_mgmt);
 		CALL_RXH(ieee80211_rx_h_action_return);
 		CALL_RXH(ieee80211_rx_h_mgmt);
@@ -185,6 +185,8 @@ struct tid_ampdu_tx {
  *	A-MSDU with individually reported subframes.
  * @reorder_buf_filtered: bitmap indicating where there are filtered frames in
  *	the reorder buffer that should be ignored when releasing frames
+ * @reorder_buf_busy: bitmap of reorder buffer slots that hold at least one
+ *	frame, used to skip over empty slots when releasing frames
  * @reorder_time: jiffies when skb was added
  * @session_timer: check if peer keeps Tx-ing on the TID (by timeout value)
  * @reorder_timer: releases expired frames from the reorder buffer.
@@ -215,6 +217,7 @@ struct tid_ampdu_rx {
 	struct rcu_head rcu_head;
 	spinlock_t reorder_lock;
 	u64 reorder_buf_filtered;
+	DECLARE_BITMAP(reorder_buf_busy, IEEE80211_MAX_AMPDU_BUF);
 	struct sk_buff_head *reorder_buf;
 	unsigned long *reorder_time;
 	struct sta_info *sta;
@@ -4,23 +4,48 @@
 #include <linux/netfilter.h>
 #include <linux/rhashtable.h>
 #include <linux/netdevice.h>
+#include <linux/percpu.h>
+#include <linux/u64_stats_sync.h>
 #include <net/ip.h>
 #include <net/ip6_route.h>
 #include <net/netfilter/nf_tables.h>
 #include <net/netfilter/nf_flow_table.h>
 #include <net/netfilter/nf_conntrack.h>
 #include <net/netfilter/nf_conntrack_core.h>
+#include <net/netfilter/nf_conntrack_acct.h>
 #include <net/netfilter/nf_conntrack_tuple.h>
 
+struct flow_offload_counter {
+	u64			packets;
+	u64			bytes;
+};
+
+/* Per-cpu traffic counters of a flow, folded into the conntrack counters
+ * by the garbage collector, so the fast path does not share cachelines.
+ */
+struct flow_offload_acct {
+	struct flow_offload_counter	counter[FLOW_OFFLOAD_DIR_MAX];
+	struct u64_stats_sync		syncp;
+};
+
 struct flow_offload_entry {
 	struct flow_offload	flow;
 	struct nf_conn		*ct;
+	struct flow_offload_acct __percpu *acct;
+	/* already added to the conntrack counters, under gc_lock */
+	struct flow_offload_counter folded[FLOW_OFFLOAD_DIR_MAX];
 	struct rcu_head		rcu_head;
 };
 
 static DEFINE_MUTEX(flowtable_lock);
 static LIST_HEAD(flowtables);
 
+/* Flows are filed into the gc wheel by the slot their timeout falls in,
+ * the wheel must cover NF_FLOW_TIMEOUT plus some scheduling slack.
+ */
+#define NF_FLOW_GC_GRANULARITY	(1U << ilog2(HZ))
+#define NF_FLOW_GC_SPAN		(NF_FLOW_GC_SLOTS * NF_FLOW_GC_GRANULARITY)
+
 static void
 flow_offload_fill_dir(struct flow_offload *flow, struct nf_conn *ct,
 		      struct nf_flow_route *route,
@@ -51,6 +76,8 @@ flow_offload_fill_dir(struct flow_offload *flow, struct nf_conn *ct,
 	ft->dst_port = ctt->dst.u.tcp.port;
 
 	ft->iifidx = route->tuple[dir].ifindex;
+	ft->pppoe_sid = route->tuple[dir].pppoe_sid;
+	memcpy(ft->pppoe_remote, route->tuple[dir].pppoe_remote, ETH_ALEN);
 	ft->oifidx = route->tuple[!dir].ifindex;
 	ft->dst_cache = dst;
 }
@@ -69,6 +96,18 @@ flow_offload_alloc(struct nf_conn *ct, struct nf_flow_route *route)
 	if (!entry)
 		goto err_ct_refcnt;
 
+	if (nf_conn_acct_find(ct)) {
+		int cpu;
+
+		entry->acct = alloc_percpu_gfp(struct flow_offload_acct,
+					       GFP_ATOMIC);
+		if (!entry->acct)
+			goto err_acct;
+
+		for_each_possible_cpu(cpu)
+			u64_stats_init(&per_cpu_ptr(entry->acct, cpu)->syncp);
+	}
+
 	flow = &entry->flow;
 
 	if (!dst_hold_safe(route->tuple[FLOW_OFFLOAD_DIR_ORIGINAL].dst))
@@ -92,6 +131,8 @@ flow_offload_alloc(struct nf_conn *ct, struct nf_flow_route *route)
 err_dst_cache_reply:
 	dst_release(route->tuple[FLOW_OFFLOAD_DIR_ORIGINAL].dst);
 err_dst_cache_original:
+	free_percpu(entry->acct);
+err_acct:
 	kfree(entry);
 err_ct_refcnt:
 	nf_ct_put(ct);
@@ -134,6 +175,15 @@ static void flow_offload_fixup_ct_state(struct nf_conn *ct)
 	ct->timeout = nfct_time_stamp + timeout;
 }
 
+static void flow_offload_free_rcu(struct rcu_head *head)
+{
+	struct flow_offload_entry *e;
+
+	e = container_of(head, struct flow_offload_entry, rcu_head);
+	free_percpu(e->acct);
+	kfree(e);
+}
+
 void flow_offload_free(struct flow_offload *flow)
 {
 	struct flow_offload_entry *e;
@@ -144,7 +194,7 @@ void flow_offload_free(struct flow_offload *flow)
 	if (flow->flags & FLOW_OFFLOAD_DYING)
 		nf_ct_delete(e->ct, 0, 0);
 	nf_ct_put(e->ct);
-	kfree_rcu(e, rcu_head);
+	call_rcu(&e->rcu_head, flow_offload_free_rcu);
 }
 EXPORT_SYMBOL_GPL(flow_offload_free);
 
@@ -182,9 +232,31 @@ static const struct rhashtable_params nf_flow_offload_rhash_params = {
 	.automatic_shrinking	= true,
 };
 
+static struct hlist_head *nf_flow_gc_slot(struct nf_flowtable *flow_table,
+					   u32 when)
+{
+	u32 slot = when / NF_FLOW_GC_GRANULARITY;
+
+	return &flow_table->gc_wheel[slot & (NF_FLOW_GC_SLOTS - 1)];
+}
+
+/* Called with gc_lock held. Flows never go into a slot the gc has
+ * already passed, they are picked up on the next run instead.
+ */
+static void nf_flow_gc_file(struct nf_flowtable *flow_table,
+			    struct flow_offload *flow)
+{
+	u32 when = flow->timeout;
+
+	if ((__s32)(when - flow_table->gc_next) < 0)
+		when = flow_table->gc_next;
+
+	hlist_add_head(&flow->gc_node, nf_flow_gc_slot(flow_table, when));
+}
+
 int flow_offload_add(struct nf_flowtable *flow_table, struct flow_offload *flow)
 {
-	flow->timeout = (u32)jiffies;
+	flow->timeout = (u32)jiffies + NF_FLOW_TIMEOUT;
 
 	rhashtable_insert_fast(&flow_table->rhashtable,
 			       &flow->tuplehash[FLOW_OFFLOAD_DIR_ORIGINAL].node,
@@ -192,15 +264,68 @@ int flow_offload_add(struct nf_flowtable *flow_table, struct flow_offload *flow)
 	rhashtable_insert_fast(&flow_table->rhashtable,
 			       &flow->tuplehash[FLOW_OFFLOAD_DIR_REPLY].node,
 			       nf_flow_offload_rhash_params);
+
+	spin_lock_bh(&flow_table->gc_lock);
+	nf_flow_gc_file(flow_table, flow);
+	spin_unlock_bh(&flow_table->gc_lock);
+
 	return 0;
 }
 EXPORT_SYMBOL_GPL(flow_offload_add);
 
+/* Add what the flow saw since the last call to the conntrack counters.
+ * Called with gc_lock held.
+ */
+static void flow_offload_acct_fold(struct flow_offload *flow)
+{
+	struct flow_offload_counter sum[FLOW_OFFLOAD_DIR_MAX] = {};
+	struct flow_offload_entry *e;
+	struct nf_conn_acct *acct;
+	int cpu, dir;
+
+	e = container_of(flow, struct flow_offload_entry, flow);
+	if (!e->acct)
+		return;
+
+	acct = nf_conn_acct_find(e->ct);
+	if (!acct)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		const struct flow_offload_acct *pcpu;
+		struct flow_offload_counter c[FLOW_OFFLOAD_DIR_MAX];
+		unsigned int start;
+
+		pcpu = per_cpu_ptr(e->acct, cpu);
+		do {
+			start = u64_stats_fetch_begin_irq(&pcpu->syncp);
+			memcpy(c, pcpu->counter, sizeof(c));
+		} while (u64_stats_fetch_retry_irq(&pcpu->syncp, start));
+
+		for (dir = 0; dir < FLOW_OFFLOAD_DIR_MAX; dir++) {
+			sum[dir].packets += c[dir].packets;
+			sum[dir].bytes += c[dir].bytes;
+		}
+	}
+
+	for (dir = 0; dir < FLOW_OFFLOAD_DIR_MAX; dir++) {
+		atomic64_add(sum[dir].packets - e->folded[dir].packets,
+			     &acct->counter[dir].packets);
+		atomic64_add(sum[dir].bytes - e->folded[dir].bytes,
+			     &acct->counter[dir].bytes);
+	}
+	memcpy(e->folded, sum, sizeof(sum));
+}
+
+/* Called with gc_lock held. */
 static void flow_offload_del(struct nf_flowtable *flow_table,
 			     struct flow_offload *flow)
 {
 	struct flow_offload_entry *e;
 
+	hlist_del_init(&flow->gc_node);
+	flow_offload_acct_fold(flow);
+
 	rhashtable_remove_fast(&flow_table->rhashtable,
 			       &flow->tuplehash[FLOW_OFFLOAD_DIR_ORIGINAL].node,
 			       nf_flow_offload_rhash_params);
@@ -214,7 +339,7 @@ static void flow_offload_del(struct nf_flowtable *flow_table,
 	flow_offload_free(flow);
 }
 
-void flow_offload_teardown(struct flow_offload *flow)
+static void __flow_offload_teardown(struct flow_offload *flow)
 {
 	struct flow_offload_entry *e;
 
@@ -223,8 +348,44 @@ void flow_offload_teardown(struct flow_offload *flow)
 	e = container_of(flow, struct flow_offload_entry, flow);
 	flow_offload_fixup_ct_state(e->ct);
 }
+
+void flow_offload_teardown(struct nf_flowtable *flow_table,
+			   struct flow_offload *flow)
+{
+	__flow_offload_teardown(flow);
+
+	/* Move the flow to the slot the next gc run visits, so that it is
+	 * gone before conntrack gc sees IPS_OFFLOAD and extends the timeout
+	 * again, and the tuple can be offloaded anew.
+	 */
+	spin_lock_bh(&flow_table->gc_lock);
+	if (!hlist_unhashed(&flow->gc_node)) {
+		hlist_del(&flow->gc_node);
+		flow->timeout = flow_table->gc_next;
+		nf_flow_gc_file(flow_table, flow);
+	}
+	spin_unlock_bh(&flow_table->gc_lock);
+}
 EXPORT_SYMBOL_GPL(flow_offload_teardown);
 
+void flow_offload_acct(struct flow_offload *flow,
+		       enum flow_offload_tuple_dir dir, unsigned int len)
+{
+	struct flow_offload_entry *e;
+	struct flow_offload_acct *acct;
+
+	e = container_of(flow, struct flow_offload_entry, flow);
+	if (!e->acct)
+		return;
+
+	acct = this_cpu_ptr(e->acct);
+	u64_stats_update_begin(&acct->syncp);
+	acct->counter[dir].packets++;
+	acct->counter[dir].bytes += len;
+	u64_stats_update_end(&acct->syncp);
+}
+EXPORT_SYMBOL_GPL(flow_offload_acct);
+
 struct flow_offload_tuple_rhash *
 flow_offload_lookup(struct nf_flowtable *flow_table,
 		    struct flow_offload_tuple *tuple)
@@ -290,6 +451,12 @@ static inline bool nf_flow_has_expired(const struct flow_offload *flow)
 	return (__s32)(flow->timeout - (u32)jiffies) <= 0;
 }
 
+static inline bool nf_flow_gc_due(const struct flow_offload *flow)
+{
+	return nf_flow_has_expired(flow) ||
+	       (flow->flags & (FLOW_OFFLOAD_DYING | FLOW_OFFLOAD_TEARDOWN));
+}
+
 static int nf_flow_offload_gc_step(struct nf_flowtable *flow_table)
 {
 	struct flow_offload_tuple_rhash *tuplehash;
@@ -316,10 +483,11 @@ static int nf_flow_offload_gc_step(struct nf_flowtable *flow_table)
 
 		flow = container_of(tuplehash, struct flow_offload, tuplehash[0]);
 
-		if (nf_flow_has_expired(flow) ||
-		    (flow->flags & (FLOW_OFFLOAD_DYING |
-				    FLOW_OFFLOAD_TEARDOWN)))
+		spin_lock_bh(&flow_table->gc_lock);
+		if (!hlist_unhashed(&flow->gc_node) &&
+		    nf_flow_gc_due(flow))
 			flow_offload_del(flow_table, flow);
+		spin_unlock_bh(&flow_table->gc_lock);
 	}
 out:
 	rhashtable_walk_stop(&hti);
@@ -328,12 +496,55 @@ static int nf_flow_offload_gc_step(struct nf_flowtable *flow_table)
 	return 1;
 }
 
+/* Only visit the wheel slots that have fully elapsed since the last run,
+ * instead of walking the whole table every second. Flows still alive are
+ * filed again according to their refreshed timeout.
+ */
+static void nf_flow_offload_gc_wheel(struct nf_flowtable *flow_table)
+{
+	struct flow_offload *flow;
+	struct hlist_node *tmp;
+	u32 now = (u32)jiffies;
+	int i;
+
+	spin_lock_bh(&flow_table->gc_lock);
+
+	if ((__s32)(now - flow_table->gc_next) > NF_FLOW_GC_SPAN)
+		flow_table->gc_next = rounddown(now, NF_FLOW_GC_GRANULARITY) -
+				      NF_FLOW_GC_SPAN;
+
+	for (i = 0; i < NF_FLOW_GC_SLOTS; i++) {
+		struct hlist_head *head;
+		u32 end;
+
+		end = flow_table->gc_next + NF_FLOW_GC_GRANULARITY;
+		if ((__s32)(now - end) < 0)
+			break;
+
+		head = nf_flow_gc_slot(flow_table, flow_table->gc_next);
+		flow_table->gc_next = end;
+
+		hlist_for_each_entry_safe(flow, tmp, head, gc_node) {
+			if (nf_flow_gc_due(flow)) {
+				flow_offload_del(flow_table, flow);
+				continue;
+			}
+
+			hlist_del(&flow->gc_node);
+			flow_offload_acct_fold(flow);
+			nf_flow_gc_file(flow_table, flow);
+		}
+	}
+
+	spin_unlock_bh(&flow_table->gc_lock);
+}
+
 static void nf_flow_offload_work_gc(struct work_struct *work)
 {
 	struct nf_flowtable *flow_table;
 
 	flow_table = container_of(work, struct nf_flowtable, gc_work.work);
-	nf_flow_offload_gc_step(flow_table);
+	nf_flow_offload_gc_wheel(flow_table);
 	queue_delayed_work(system_power_efficient_wq, &flow_table->gc_work, HZ);
 }
 
@@ -455,9 +666,13 @@ EXPORT_SYMBOL_GPL(nf_flow_dnat_port);
 
 int nf_flow_table_init(struct nf_flowtable *flowtable)
 {
-	int err;
+	int err, i;
 
 	INIT_DEFERRABLE_WORK(&flowtable->gc_work, nf_flow_offload_work_gc);
+	spin_lock_init(&flowtable->gc_lock);
+	for (i = 0; i < NF_FLOW_GC_SLOTS; i++)
+		INIT_HLIST_HEAD(&flowtable->gc_wheel[i]);
+	flowtable->gc_next = rounddown((u32)jiffies, NF_FLOW_GC_GRANULARITY);
 
 	err = rhashtable_init(&flowtable->rhashtable,
 			      &nf_flow_offload_rhash_params);
@@ -480,12 +695,17 @@ static void nf_flow_table_do_cleanup(struct flow_offload *flow, void *data)
 	struct net_device *dev = data;
 
 	if (!dev) {
-		flow_offload_teardown(flow);
+		__flow_offload_teardown(flow);
 		return;
 	}
 
+	/* PPPoE flows are keyed on the device below the PPP device, catch
+	 * the PPP device going down through the routes.
+	 */
 	if (flow->tuplehash[0].tuple.iifidx == dev->ifindex ||
-	    flow->tuplehash[1].tuple.iifidx == dev->ifindex)
+	    flow->tuplehash[1].tuple.iifidx == dev->ifindex ||
+	    flow->tuplehash[0].tuple.dst_cache->dev == dev ||
+	    flow->tuplehash[1].tuple.dst_cache->dev == dev)
 		flow_offload_dead(flow);
 }
 
@@ -493,7 +713,7 @@ static void nf_flow_table_iterate_cleanup(struct nf_flowtable *flowtable,
 					  struct net_device *dev)
 {
 	nf_flow_table_iterate(flowtable, nf_flow_table_do_cleanup, dev);
-	flush_delayed_work(&flowtable->gc_work);
+	nf_flow_offload_gc_step(flowtable);
 }
 
 void nf_flow_table_cleanup(struct net *net, struct net_device *dev)
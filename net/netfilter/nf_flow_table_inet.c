@@ -10,7 +10,12 @@ static unsigned int
 nf_flow_offload_inet_hook(void *priv, struct sk_buff *skb,
 			  const struct nf_hook_state *state)
 {
-	switch (skb->protocol) {
+	__be16 proto = skb->protocol;
+
+	if (proto == htons(ETH_P_PPP_SES))
+		proto = nf_flow_pppoe_proto(skb);
+
+	switch (proto) {
 	case htons(ETH_P_IP):
 		return nf_flow_offload_ip_hook(priv, skb, state);
 	case htons(ETH_P_IPV6):
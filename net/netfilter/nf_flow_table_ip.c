@@ -6,6 +6,7 @@
 #include <linux/ip.h>
 #include <linux/ipv6.h>
 #include <linux/netdevice.h>
+#include <linux/if_vlan.h>
 #include <net/ip.h>
 #include <net/ipv6.h>
 #include <net/ip6_route.h>
@@ -15,7 +16,8 @@
 #include <linux/tcp.h>
 #include <linux/udp.h>
 
-static int nf_flow_state_check(struct flow_offload *flow, int proto,
+static int nf_flow_state_check(struct nf_flowtable *flow_table,
+			       struct flow_offload *flow, int proto,
 			       struct sk_buff *skb, unsigned int thoff)
 {
 	struct tcphdr *tcph;
@@ -28,7 +30,7 @@ static int nf_flow_state_check(struct flow_offload *flow, int proto,
 
 	tcph = (void *)(skb_network_header(skb) + thoff);
 	if (unlikely(tcph->fin || tcph->rst)) {
-		flow_offload_teardown(flow);
+		flow_offload_teardown(flow_table, flow);
 		return -1;
 	}
 
@@ -198,6 +200,110 @@ static int nf_flow_tuple_ip(struct sk_buff *skb, const struct net_device *dev,
 	return 0;
 }
 
+/* Frames carrying the tag of a VLAN device stacked on the device the hook
+ * runs on belong to flows that were set up on the VLAN device. Resolve it
+ * here so those frames skip the second pass through the receive path.
+ */
+static struct net_device *nf_flow_ingress_dev(const struct sk_buff *skb,
+					      const struct nf_hook_state *state)
+{
+	struct net_device *dev;
+
+	/* Priority-tagged frames (VID 0) are untagged as far as the VLAN
+	 * code is concerned, see __netif_receive_skb_core().
+	 */
+	if (!skb_vlan_tag_present(skb) || !skb_vlan_tag_get_id(skb))
+		return state->in;
+
+	dev = __vlan_find_dev_deep_rcu(state->in, skb->vlan_proto,
+				       skb_vlan_tag_get_id(skb));
+	if (!dev || !(dev->flags & IFF_UP) ||
+	    !net_eq(dev_net(dev), state->net))
+		return NULL;
+
+	return dev;
+}
+
+/* PPPoE session frames of a flow arrive on the Ethernet device below the
+ * PPP device. Strip the session header of a frame carrying @proto so it
+ * can be looked up like a plain one, and return the session id, which is
+ * part of the tuple. Returns 0 if the frame is not such a frame.
+ */
+static __be16 nf_flow_pppoe_pull(struct sk_buff *skb, __be16 proto)
+{
+	struct pppoe_hdr *ph;
+	unsigned int len;
+	__be16 sid;
+
+	if (nf_flow_pppoe_proto(skb) != proto)
+		return 0;
+
+	ph = (struct pppoe_hdr *)skb->data;
+	len = ntohs(ph->length);
+	if (ph->ver != 1 || ph->type != 1 || ph->code || !ph->sid ||
+	    len < PPPOE_SES_HLEN - sizeof(*ph) ||
+	    sizeof(*ph) + len > skb->len)
+		return 0;
+
+	sid = ph->sid;
+
+	/* drop the Ethernet padding, as pppoe_rcv() would */
+	if (pskb_trim_rcsum(skb, sizeof(*ph) + len))
+		return 0;
+
+	skb_pull_rcsum(skb, PPPOE_SES_HLEN);
+	skb_reset_network_header(skb);
+	skb->protocol = proto;
+
+	return sid;
+}
+
+/* Give a frame that is not forwarded back to the slow path as it came. */
+static void nf_flow_pppoe_push_back(struct sk_buff *skb)
+{
+	skb_push_rcsum(skb, PPPOE_SES_HLEN);
+	skb_reset_network_header(skb);
+	skb->protocol = htons(ETH_P_PPP_SES);
+}
+
+/* Send a frame into the PPPoE session of @tuple, the reverse tuple of the
+ * direction it is forwarded in. This is what the PPP device and the pppoe
+ * channel would do, see __pppoe_xmit().
+ */
+static unsigned int nf_flow_pppoe_xmit(struct sk_buff *skb,
+				       struct net_device *outdev,
+				       const struct flow_offload_tuple *tuple,
+				       __be16 ppp_proto)
+{
+	struct pppoe_hdr *ph;
+	int data_len;
+
+	if (skb_cow_head(skb, LL_RESERVED_SPACE(outdev) + PPPOE_SES_HLEN))
+		return NF_DROP;
+
+	data_len = skb->len + PPPOE_SES_HLEN - sizeof(*ph);
+	__skb_push(skb, PPPOE_SES_HLEN);
+	skb_reset_network_header(skb);
+
+	ph = (struct pppoe_hdr *)skb->data;
+	ph->ver = 1;
+	ph->type = 1;
+	ph->code = 0;
+	ph->sid = tuple->pppoe_sid;
+	ph->length = htons(data_len);
+	*(__be16 *)(skb->data + sizeof(*ph)) = ppp_proto;
+
+	skb->protocol = htons(ETH_P_PPP_SES);
+	skb->dev = outdev;
+	if (dev_hard_header(skb, outdev, ETH_P_PPP_SES, tuple->pppoe_remote,
+			    NULL, data_len) < 0)
+		return NF_DROP;
+
+	dev_queue_xmit(skb);
+
+	return NF_STOLEN;
+}
+
 /* Based on ip_exceeds_mtu(). */
 static bool nf_flow_exceeds_mtu(const struct sk_buff *skb, unsigned int mtu)
 {
@@ -210,27 +316,29 @@ static bool nf_flow_exceeds_mtu(const struct sk_buff *skb, unsigned int mtu)
 	return true;
 }
 
-unsigned int
-nf_flow_offload_ip_hook(void *priv, struct sk_buff *skb,
-			const struct nf_hook_state *state)
+static unsigned int
+nf_flow_offload_ip(struct nf_flowtable *flow_table, struct sk_buff *skb,
+		   const struct nf_hook_state *state, __be16 pppoe_sid)
 {
 	struct flow_offload_tuple_rhash *tuplehash;
-	struct nf_flowtable *flow_table = priv;
 	struct flow_offload_tuple tuple = {};
 	enum flow_offload_tuple_dir dir;
 	struct flow_offload *flow;
-	struct net_device *outdev;
+	struct net_device *outdev, *indev;
 	struct rtable *rt;
 	unsigned int thoff;
 	struct iphdr *iph;
 	__be32 nexthop;
 
-	if (skb->protocol != htons(ETH_P_IP))
+	indev = nf_flow_ingress_dev(skb, state);
+	if (!indev)
 		return NF_ACCEPT;
 
-	if (nf_flow_tuple_ip(skb, state->in, &tuple) < 0)
+	if (nf_flow_tuple_ip(skb, indev, &tuple) < 0)
 		return NF_ACCEPT;
 
+	tuple.pppoe_sid = pppoe_sid;
+
 	tuplehash = flow_offload_lookup(flow_table, &tuple);
 	if (tuplehash == NULL)
 		return NF_ACCEPT;
@@ -251,7 +359,8 @@ nf_flow_offload_ip_hook(void *priv, struct sk_buff *skb,
 		return NF_DROP;
 
 	thoff = ip_hdr(skb)->ihl * 4;
-	if (nf_flow_state_check(flow, ip_hdr(skb)->protocol, skb, thoff))
+	if (nf_flow_state_check(flow_table, flow, ip_hdr(skb)->protocol, skb,
+				thoff))
 		return NF_ACCEPT;
 
 	if (flow->flags & (FLOW_OFFLOAD_SNAT | FLOW_OFFLOAD_DNAT) &&
@@ -259,9 +368,17 @@ nf_flow_offload_ip_hook(void *priv, struct sk_buff *skb,
 		return NF_DROP;
 
 	flow->timeout = (u32)jiffies + NF_FLOW_TIMEOUT;
+	flow_offload_acct(flow, dir, skb->len);
 	iph = ip_hdr(skb);
 	ip_decrease_ttl(iph);
 
+	/* the tag was consumed by the lookup, don't leak it to the egress */
+	skb->vlan_tci = 0;
+	if (flow->tuplehash[!dir].tuple.pppoe_sid)
+		return nf_flow_pppoe_xmit(skb, outdev,
+					  &flow->tuplehash[!dir].tuple,
+					  htons(PPP_IP));
+
 	skb->dev = outdev;
 	nexthop = rt_nexthop(rt, flow->tuplehash[!dir].tuple.src_v4.s_addr);
 	skb_dst_set_noref(skb, &rt->dst);
@@ -269,6 +386,28 @@ nf_flow_offload_ip_hook(void *priv, struct sk_buff *skb,
 
 	return NF_STOLEN;
 }
+
+unsigned int
+nf_flow_offload_ip_hook(void *priv, struct sk_buff *skb,
+			const struct nf_hook_state *state)
+{
+	__be16 pppoe_sid = 0;
+	unsigned int ret;
+
+	if (skb->protocol == htons(ETH_P_PPP_SES)) {
+		pppoe_sid = nf_flow_pppoe_pull(skb, htons(ETH_P_IP));
+		if (!pppoe_sid)
+			return NF_ACCEPT;
+	} else if (skb->protocol != htons(ETH_P_IP)) {
+		return NF_ACCEPT;
+	}
+
+	ret = nf_flow_offload_ip(priv, skb, state, pppoe_sid);
+	if (ret == NF_ACCEPT && pppoe_sid)
+		nf_flow_pppoe_push_back(skb);
+
+	return ret;
+}
 EXPORT_SYMBOL_GPL(nf_flow_offload_ip_hook);
 
 static int nf_flow_nat_ipv6_tcp(struct sk_buff *skb, unsigned int thoff,
@@ -429,26 +568,28 @@ static int nf_flow_tuple_ipv6(struct sk_buff *skb, const struct net_device *dev,
 	return 0;
 }
 
-unsigned int
-nf_flow_offload_ipv6_hook(void *priv, struct sk_buff *skb,
-			  const struct nf_hook_state *state)
+static unsigned int
+nf_flow_offload_ipv6(struct nf_flowtable *flow_table, struct sk_buff *skb,
+		     const struct nf_hook_state *state, __be16 pppoe_sid)
 {
 	struct flow_offload_tuple_rhash *tuplehash;
-	struct nf_flowtable *flow_table = priv;
 	struct flow_offload_tuple tuple = {};
 	enum flow_offload_tuple_dir dir;
 	struct flow_offload *flow;
-	struct net_device *outdev;
+	struct net_device *outdev, *indev;
 	struct in6_addr *nexthop;
 	struct ipv6hdr *ip6h;
 	struct rt6_info *rt;
 
-	if (skb->protocol != htons(ETH_P_IPV6))
+	indev = nf_flow_ingress_dev(skb, state);
+	if (!indev)
 		return NF_ACCEPT;
 
-	if (nf_flow_tuple_ipv6(skb, state->in, &tuple) < 0)
+	if (nf_flow_tuple_ipv6(skb, indev, &tuple) < 0)
 		return NF_ACCEPT;
 
+	tuple.pppoe_sid = pppoe_sid;
+
 	tuplehash = flow_offload_lookup(flow_table, &tuple);
 	if (tuplehash == NULL)
 		return NF_ACCEPT;
@@ -464,7 +605,7 @@ nf_flow_offload_ipv6_hook(void *priv, struct sk_buff *skb,
 	if (unlikely(nf_flow_exceeds_mtu(skb, flow->tuplehash[dir].tuple.mtu)))
 		return NF_ACCEPT;
 
-	if (nf_flow_state_check(flow, ipv6_hdr(skb)->nexthdr, skb,
+	if (nf_flow_state_check(flow_table, flow, ipv6_hdr(skb)->nexthdr, skb,
 				sizeof(*ip6h)))
 		return NF_ACCEPT;
 
@@ -476,9 +617,16 @@ nf_flow_offload_ipv6_hook(void *priv, struct sk_buff *skb,
 		return NF_DROP;
 
 	flow->timeout = (u32)jiffies + NF_FLOW_TIMEOUT;
+	flow_offload_acct(flow, dir, skb->len);
 	ip6h = ipv6_hdr(skb);
 	ip6h->hop_limit--;
 
+	skb->vlan_tci = 0;
+	if (flow->tuplehash[!dir].tuple.pppoe_sid)
+		return nf_flow_pppoe_xmit(skb, outdev,
+					  &flow->tuplehash[!dir].tuple,
+					  htons(PPP_IPV6));
+
 	skb->dev = outdev;
 	nexthop = rt6_nexthop(rt, &flow->tuplehash[!dir].tuple.src_v6);
 	skb_dst_set_noref(skb, &rt->dst);
@@ -486,4 +634,26 @@ nf_flow_offload_ipv6_hook(void *priv, struct sk_buff *skb,
 
 	return NF_STOLEN;
 }
+
+unsigned int
+nf_flow_offload_ipv6_hook(void *priv, struct sk_buff *skb,
+			  const struct nf_hook_state *state)
+{
+	__be16 pppoe_sid = 0;
+	unsigned int ret;
+
+	if (skb->protocol == htons(ETH_P_PPP_SES)) {
+		pppoe_sid = nf_flow_pppoe_pull(skb, htons(ETH_P_IPV6));
+		if (!pppoe_sid)
+			return NF_ACCEPT;
+	} else if (skb->protocol != htons(ETH_P_IPV6)) {
+		return NF_ACCEPT;
+	}
+
+	ret = nf_flow_offload_ipv6(priv, skb, state, pppoe_sid);
+	if (ret == NF_ACCEPT && pppoe_sid)
+		nf_flow_pppoe_push_back(skb);
+
+	return ret;
+}
 EXPORT_SYMBOL_GPL(nf_flow_offload_ipv6_hook);
@@ -5,6 +5,8 @@
 #include <linux/netfilter.h>
 #include <linux/workqueue.h>
 #include <linux/spinlock.h>
+#include <linux/if_arp.h>
+#include <linux/ppp_channel.h>
 #include <linux/netfilter/nf_tables.h>
 #include <net/ip.h> /* for ipv4 options. */
 #include <net/netfilter/nf_tables.h>
@@ -17,6 +19,27 @@ struct nft_flow_offload {
 	struct nft_flowtable	*flowtable;
 };
 
+/* Flows through a PPPoE session are set up on the Ethernet device below the
+ * PPP device. The flowtable strips and pushes the session header itself.
+ */
+static void nft_flow_route_dev(struct nf_flow_route *route,
+			       enum ip_conntrack_dir dir,
+			       const struct net_device *dev)
+{
+	struct ppp_channel_path path;
+
+	route->tuple[dir].ifindex = dev->ifindex;
+	route->tuple[dir].pppoe_sid = 0;
+
+	if (dev->type != ARPHRD_PPP || ppp_dev_fill_path(dev, &path) < 0 ||
+	    path.proto != htons(ETH_P_PPP_SES))
+		return;
+
+	route->tuple[dir].ifindex = path.dev->ifindex;
+	route->tuple[dir].pppoe_sid = path.id;
+	memcpy(route->tuple[dir].pppoe_remote, path.h_dest, ETH_ALEN);
+}
+
 static int nft_flow_route(const struct nft_pktinfo *pkt,
 			  const struct nf_conn *ct,
 			  struct nf_flow_route *route,
@@ -41,9 +64,9 @@ static int nft_flow_route(const struct nft_pktinfo *pkt,
 		return -ENOENT;
 
 	route->tuple[dir].dst		= this_dst;
-	route->tuple[dir].ifindex	= nft_in(pkt)->ifindex;
 	route->tuple[!dir].dst		= other_dst;
-	route->tuple[!dir].ifindex	= nft_out(pkt)->ifindex;
+	nft_flow_route_dev(route, dir, nft_in(pkt));
+	nft_flow_route_dev(route, !dir, nft_out(pkt));
 
 	return 0;
 }
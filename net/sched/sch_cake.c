@@ -46,6 +46,17 @@
  * priority-based weight (high) or a bandwidth-based weight (low) is used for
  * that tin in the current pass.
  *
+ * On multiqueue devices, CAKE can run as one instance per transmit queue
+ * below mq, configured with the same bandwidth and a common shaper group.
+ * Flow hashing, AQM and the tin scheduling then run in parallel under the
+ * per-queue locks, and only the global shaper clock and its failsafe are
+ * shared through atomic variables.  Per-host fairness is only kept within
+ * each queue, so it holds approximately as long as the device spreads hosts
+ * evenly over its queues.  Each packet still costs up to two cmpxchg on the
+ * cacheline holding the group clocks, so throughput stops scaling with the
+ * number of queues once that cacheline saturates; the gain is largest with
+ * few queues and heavy per-packet work such as the ACK filter.
+ *
  * This qdisc was inspired by Eric Dumazet's fq_codel code, which he kindly
  * granted us permission to leverage.
  */
@@ -198,6 +209,22 @@ struct cake_tin_data {
 	u32	way_collisions;
 }; /* number of tins is small, so size of this struct doesn't matter much */
 
+/* Global shaper clocks shared by the instances of a shaper group */
+struct cake_shaper_group {
+	struct list_head	list;
+	possible_net_t		net;
+	u32			id;
+	u32			users;
+	atomic64_t		time_next_packet;
+	atomic64_t		failsafe_next_packet;
+};
+
+/* how far a group clock may lag behind, to absorb scheduling latency */
+#define CAKE_SHAPER_GROUP_SLACK_NS	NSEC_PER_MSEC
+
+static DEFINE_MUTEX(cake_shaper_groups_lock);
+static LIST_HEAD(cake_shaper_groups);
+
 struct cake_sched_data {
 	struct tcf_proto __rcu *filter_list; /* optional external classifier */
 	struct tcf_block *block;
@@ -216,6 +243,7 @@ struct cake_sched_data {
 	u16		rate_shft;
 	ktime_t		time_next_packet;
 	ktime_t		failsafe_next_packet;
+	struct cake_shaper_group *shaper_group;
 	u64		rate_ns;
 	u64		rate_bps;
 	u16		rate_flags;
@@ -1406,6 +1434,48 @@ static void cake_heapify_up(struct cake_sched_data *q, u16 i)
 	}
 }
 
+static s64 cake_shaper_group_charge(atomic64_t *clock, ktime_t now, u64 dur)
+{
+	s64 floor = ktime_to_ns(now) - CAKE_SHAPER_GROUP_SLACK_NS;
+	s64 old, next;
+
+	do {
+		old = atomic64_read(clock);
+		next = max(old, floor) + dur;
+	} while (atomic64_cmpxchg(clock, old, next) != old);
+
+	return next;
+}
+
+/* Same as the private shaper: dropped packets are charged to the shaper
+ * clock only, so the failsafe clock lets the group recover from a burst
+ * of drops on any of its queues.
+ */
+static void cake_shaper_group_advance(struct cake_sched_data *q, ktime_t now,
+				      u64 dur, u64 failsafe_dur, bool drop)
+{
+	struct cake_shaper_group *group = q->shaper_group;
+
+	q->time_next_packet =
+		ns_to_ktime(cake_shaper_group_charge(&group->time_next_packet,
+						     now, dur));
+	if (!drop)
+		q->failsafe_next_packet = ns_to_ktime(
+			cake_shaper_group_charge(&group->failsafe_next_packet,
+						 now, failsafe_dur));
+}
+
+/* Pick up the time charged by the other instances of the group. */
+static void cake_shaper_group_sync(struct cake_sched_data *q)
+{
+	struct cake_shaper_group *group = q->shaper_group;
+
+	q->time_next_packet =
+		ns_to_ktime(atomic64_read(&group->time_next_packet));
+	q->failsafe_next_packet =
+		ns_to_ktime(atomic64_read(&group->failsafe_next_packet));
+}
+
 static int cake_advance_shaper(struct cake_sched_data *q,
 			       struct cake_tin_data *b,
 			       struct sk_buff *skb,
@@ -1429,6 +1499,12 @@ static int cake_advance_shaper(struct cake_sched_data *q,
 				      ktime_add_ns(now, tin_dur)))
 			b->time_next_packet = ktime_add_ns(now, tin_dur);
 
+		if (q->shaper_group) {
+			cake_shaper_group_advance(q, now, global_dur,
+						  failsafe_dur, drop);
+			return len;
+		}
+
 		q->time_next_packet = ktime_add_ns(q->time_next_packet,
 						   global_dur);
 		if (!drop)
@@ -1632,6 +1708,10 @@ static s32 cake_enqueue(struct sk_buff *skb, struct Qdisc *sch,
 			b->time_next_packet = now;
 
 		if (!sch->q.qlen) {
+			/* the group clock moved on while we were idle */
+			if (q->shaper_group)
+				cake_shaper_group_sync(q);
+
 			if (ktime_before(q->time_next_packet, now)) {
 				q->failsafe_next_packet = now;
 				q->time_next_packet = now;
@@ -1864,6 +1944,9 @@ static struct sk_buff *cake_dequeue(struct Qdisc *sch)
 		return NULL;
 
 	/* global hard shaper */
+	if (q->shaper_group)
+		cake_shaper_group_sync(q);
+
 	if (ktime_after(q->time_next_packet, now) &&
 	    ktime_after(q->failsafe_next_packet, now)) {
 		u64 next = min(ktime_to_ns(q->time_next_packet),
@@ -2129,6 +2212,7 @@ static const struct nla_policy cake_policy[TCA_CAKE_MAX + 1] = {
 	[TCA_CAKE_MPU]		 = { .type = NLA_U32 },
 	[TCA_CAKE_INGRESS]	 = { .type = NLA_U32 },
 	[TCA_CAKE_ACK_FILTER]	 = { .type = NLA_U32 },
+	[TCA_CAKE_SHAPER_GROUP]	 = { .type = NLA_U32 },
 };
 
 static void cake_set_rate(struct cake_tin_data *b, u64 rate, u32 mtu,
@@ -2465,6 +2549,71 @@ static void cake_reconfigure(struct Qdisc *sch)
 				  q->buffer_config_limit));
 }
 
+/* Called with cake_shaper_groups_lock held. */
+static struct cake_shaper_group *cake_shaper_group_get(struct net *net,
+						       u32 id)
+{
+	struct cake_shaper_group *group;
+
+	list_for_each_entry(group, &cake_shaper_groups, list) {
+		if (group->id == id && net_eq(read_pnet(&group->net), net)) {
+			group->users++;
+			return group;
+		}
+	}
+
+	group = kzalloc(sizeof(*group), GFP_KERNEL);
+	if (!group)
+		return NULL;
+
+	write_pnet(&group->net, net);
+	group->id = id;
+	group->users = 1;
+	atomic64_set(&group->time_next_packet, ktime_get_ns());
+	atomic64_set(&group->failsafe_next_packet, ktime_get_ns());
+	list_add(&group->list, &cake_shaper_groups);
+
+	return group;
+}
+
+/* Called with cake_shaper_groups_lock held. */
+static void cake_shaper_group_put(struct cake_shaper_group *group)
+{
+	if (!group || --group->users)
+		return;
+
+	list_del(&group->list);
+	kfree(group);
+}
+
+static int cake_set_shaper_group(struct Qdisc *sch, u32 id)
+{
+	struct cake_sched_data *q = qdisc_priv(sch);
+	struct cake_shaper_group *group = NULL, *old;
+
+	if (q->shaper_group ? q->shaper_group->id == id : !id)
+		return 0;
+
+	mutex_lock(&cake_shaper_groups_lock);
+	if (id) {
+		group = cake_shaper_group_get(dev_net(qdisc_dev(sch)), id);
+		if (!group) {
+			mutex_unlock(&cake_shaper_groups_lock);
+			return -ENOMEM;
+		}
+	}
+
+	sch_tree_lock(sch);
+	old = q->shaper_group;
+	q->shaper_group = group;
+	sch_tree_unlock(sch);
+
+	cake_shaper_group_put(old);
+	mutex_unlock(&cake_shaper_groups_lock);
+
+	return 0;
+}
+
 static int cake_change(struct Qdisc *sch, struct nlattr *opt,
 		       struct netlink_ext_ack *extack)
 {
@@ -2575,6 +2724,13 @@ static int cake_change(struct Qdisc *sch, struct nlattr *opt,
 			q->rate_flags &= ~CAKE_FLAG_SPLIT_GSO;
 	}
 
+	if (tb[TCA_CAKE_SHAPER_GROUP]) {
+		err = cake_set_shaper_group(sch,
+					    nla_get_u32(tb[TCA_CAKE_SHAPER_GROUP]));
+		if (err)
+			return err;
+	}
+
 	if (q->tins) {
 		sch_tree_lock(sch);
 		cake_reconfigure(sch);
@@ -2591,6 +2747,10 @@ static void cake_destroy(struct Qdisc *sch)
 	qdisc_watchdog_cancel(&q->watchdog);
 	tcf_block_put(q->block);
 	kvfree(q->tins);
+
+	mutex_lock(&cake_shaper_groups_lock);
+	cake_shaper_group_put(q->shaper_group);
+	mutex_unlock(&cake_shaper_groups_lock);
 }
 
 static int cake_init(struct Qdisc *sch, struct nlattr *opt,
@@ -2734,6 +2894,10 @@ static int cake_dump(struct Qdisc *sch, struct sk_buff *skb)
 			!!(q->rate_flags & CAKE_FLAG_SPLIT_GSO)))
 		goto nla_put_failure;
 
+	if (q->shaper_group &&
+	    nla_put_u32(skb, TCA_CAKE_SHAPER_GROUP, q->shaper_group->id))
+		goto nla_put_failure;
+
 	return nla_nest_end(skb, opts);
 
 nla_put_failure:
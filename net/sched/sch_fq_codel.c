@@ -58,6 +58,8 @@ struct fq_codel_sched_data {
 	struct tcf_block *block;
 	struct fq_codel_flow *flows;	/* Flows table [flows_cnt] */
 	u32		*backlogs;	/* backlog table [flows_cnt] */
+	u16		*heap;		/* max-heap of flows by backlog */
+	u16		*heap_idx;	/* position of each flow in heap */
 	u32		flows_cnt;	/* number of flows */
 	u32		quantum;	/* psched_mtu(qdisc_dev(sch)); */
 	u32		drop_batch_size;
@@ -140,29 +142,109 @@ static inline void flow_queue_add(struct fq_codel_flow *flow,
 	skb->next = NULL;
 }
 
+static void fq_codel_heap_init(struct fq_codel_sched_data *q)
+{
+	u32 i;
+
+	for (i = 0; i < q->flows_cnt; i++) {
+		q->heap[i] = i;
+		q->heap_idx[i] = i;
+	}
+}
+
+static void fq_codel_heap_swap(struct fq_codel_sched_data *q, u32 i, u32 j)
+{
+	u16 ii = q->heap[i];
+	u16 jj = q->heap[j];
+
+	q->heap[i] = jj;
+	q->heap[j] = ii;
+
+	q->heap_idx[ii] = j;
+	q->heap_idx[jj] = i;
+}
+
+static u32 fq_codel_heap_get_backlog(const struct fq_codel_sched_data *q,
+				     u32 i)
+{
+	return q->backlogs[q->heap[i]];
+}
+
+/* The backlog of flow idx went down, move it towards the leaves. */
+static void fq_codel_heap_down(struct fq_codel_sched_data *q, u32 idx)
+{
+	u32 i = q->heap_idx[idx];
+	u32 mb = q->backlogs[idx];
+	u32 m = i;
+
+	for (;;) {
+		u32 l = m + m + 1;
+		u32 r = l + 1;
+
+		if (l < q->flows_cnt) {
+			u32 lb = fq_codel_heap_get_backlog(q, l);
+
+			if (lb > mb) {
+				m  = l;
+				mb = lb;
+			}
+		}
+
+		if (r < q->flows_cnt) {
+			u32 rb = fq_codel_heap_get_backlog(q, r);
+
+			if (rb > mb) {
+				m  = r;
+				mb = rb;
+			}
+		}
+
+		if (m == i)
+			break;
+
+		fq_codel_heap_swap(q, i, m);
+		i = m;
+		mb = q->backlogs[idx];
+	}
+}
+
+/* The backlog of flow idx went up, move it towards the root. */
+static void fq_codel_heap_up(struct fq_codel_sched_data *q, u32 idx)
+{
+	u32 i = q->heap_idx[idx];
+	u32 ib = q->backlogs[idx];
+
+	while (i > 0) {
+		u32 p = (i - 1) >> 1;
+
+		if (ib <= fq_codel_heap_get_backlog(q, p))
+			break;
+
+		fq_codel_heap_swap(q, i, p);
+		i = p;
+	}
+}
+
 static unsigned int fq_codel_drop(struct Qdisc *sch, unsigned int max_packets,
 				  struct sk_buff **to_free)
 {
 	struct fq_codel_sched_data *q = qdisc_priv(sch);
 	struct sk_buff *skb;
-	unsigned int maxbacklog = 0, idx = 0, i, len;
+	unsigned int maxbacklog, idx, i, len;
 	struct fq_codel_flow *flow;
 	unsigned int threshold;
 	unsigned int mem = 0;
 
-	/* Queue is full! Find the fat flow and drop packet(s) from it.
-	 * This might sound expensive, but with 1024 flows, we scan
-	 * 4KB of memory, and we dont need to handle a complex tree
-	 * in fast path (packet queue/enqueue) with many cache misses.
-	 * In stress mode, we'll try to drop 64 packets from the flow,
-	 * amortizing this linear lookup to one cache line per drop.
+	/* Queue is full! Drop packet(s) from the fat flow.
+	 * The flows are kept in a max-heap on their backlog, so the fat
+	 * flow is at its root instead of having to scan 4KB of memory
+	 * with 1024 flows. Enqueue and dequeue usually only compare
+	 * against a parent or the children, a flow only travels far in
+	 * the heap when it becomes or stops being one of the fattest.
+	 * In stress mode, we'll try to drop 64 packets from the flow.
 	 */
-	for (i = 0; i < q->flows_cnt; i++) {
-		if (q->backlogs[i] > maxbacklog) {
-			maxbacklog = q->backlogs[i];
-			idx = i;
-		}
-	}
+	idx = q->heap[0];
+	maxbacklog = q->backlogs[idx];
 
 	/* Our goal is to drop half of this fat flow backlog */
 	threshold = maxbacklog >> 1;
@@ -179,6 +261,7 @@ static unsigned int fq_codel_drop(struct Qdisc *sch, unsigned int max_packets,
 
 	flow->dropped += i;
 	q->backlogs[idx] -= len;
+	fq_codel_heap_down(q, idx);
 	q->memory_usage -= mem;
 	sch->qstats.drops += i;
 	sch->qstats.backlog -= len;
@@ -209,6 +292,7 @@ static int fq_codel_enqueue(struct sk_buff *skb, struct Qdisc *sch,
 	flow = &q->flows[idx];
 	flow_queue_add(flow, skb);
 	q->backlogs[idx] += qdisc_pkt_len(skb);
+	fq_codel_heap_up(q, idx);
 	qdisc_qstats_backlog_inc(sch, skb);
 
 	if (list_empty(&flow->flowchain)) {
@@ -228,10 +312,9 @@ static int fq_codel_enqueue(struct sk_buff *skb, struct Qdisc *sch,
 
 	/* save this packet length as it might be dropped by fq_codel_drop() */
 	pkt_len = qdisc_pkt_len(skb);
-	/* fq_codel_drop() is quite expensive, as it performs a linear search
-	 * in q->backlogs[] to find a fat flow.
-	 * So instead of dropping a single packet, drop half of its backlog
-	 * with a 64 packets limit to not add a too big cpu spike here.
+	/* Instead of dropping a single packet, drop half of the fat flow
+	 * backlog with a 64 packets limit, so that a flooding flow does not
+	 * get us back here for every packet.
 	 */
 	ret = fq_codel_drop(sch, q->drop_batch_size, to_free);
 
@@ -269,6 +352,7 @@ static struct sk_buff *dequeue_func(struct codel_vars *vars, void *ctx)
 	if (flow->head) {
 		skb = dequeue_head(flow);
 		q->backlogs[flow - q->flows] -= qdisc_pkt_len(skb);
+		fq_codel_heap_down(q, flow - q->flows);
 		q->memory_usage -= get_codel_cb(skb)->mem_usage;
 		sch->q.qlen--;
 		sch->qstats.backlog -= qdisc_pkt_len(skb);
@@ -360,6 +444,7 @@ static void fq_codel_reset(struct Qdisc *sch)
 		codel_vars_init(&flow->cvars);
 	}
 	memset(q->backlogs, 0, q->flows_cnt * sizeof(u32));
+	fq_codel_heap_init(q);
 	sch->q.qlen = 0;
 	sch->qstats.backlog = 0;
 	q->memory_usage = 0;
@@ -455,6 +540,8 @@ static void fq_codel_destroy(struct Qdisc *sch)
 	struct fq_codel_sched_data *q = qdisc_priv(sch);
 
 	tcf_block_put(q->block);
+	kvfree(q->heap_idx);
+	kvfree(q->heap);
 	kvfree(q->backlogs);
 	kvfree(q->flows);
 }
@@ -497,7 +584,9 @@ static int fq_codel_init(struct Qdisc *sch, struct nlattr *opt,
 			goto init_failure;
 		}
 		q->backlogs = kvcalloc(q->flows_cnt, sizeof(u32), GFP_KERNEL);
-		if (!q->backlogs) {
+		q->heap = kvcalloc(q->flows_cnt, sizeof(u16), GFP_KERNEL);
+		q->heap_idx = kvcalloc(q->flows_cnt, sizeof(u16), GFP_KERNEL);
+		if (!q->backlogs || !q->heap || !q->heap_idx) {
 			err = -ENOMEM;
 			goto alloc_failure;
 		}
@@ -507,6 +596,7 @@ static int fq_codel_init(struct Qdisc *sch, struct nlattr *opt,
 			INIT_LIST_HEAD(&flow->flowchain);
 			codel_vars_init(&flow->cvars);
 		}
+		fq_codel_heap_init(q);
 	}
 	if (sch->limit >= 1)
 		sch->flags |= TCQ_F_CAN_BYPASS;
@@ -515,7 +605,13 @@ static int fq_codel_init(struct Qdisc *sch, struct nlattr *opt,
 	return 0;
 
 alloc_failure:
+	kvfree(q->heap_idx);
+	kvfree(q->heap);
+	kvfree(q->backlogs);
 	kvfree(q->flows);
+	q->heap_idx = NULL;
+	q->heap = NULL;
+	q->backlogs = NULL;
 	q->flows = NULL;
 init_failure:
 	q->flows_cnt = 0;
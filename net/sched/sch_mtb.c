@@ -0,0 +1,437 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/* net/sched/sch_mtb.c	Multiqueue Token Bucket.
+ *
+ * A token bucket shaper for multiqueue devices. One instance is attached
+ * to every transmit queue below mq, all instances using the same group id
+ * share the group rate:
+ *
+ *	tc qdisc add dev eth0 root handle 1: mq
+ *	tc qdisc add dev eth0 parent 1:1 mtb group 7 rate 1gbit
+ *	tc qdisc add dev eth0 parent 1:2 mtb group 7
+ *	...
+ *
+ * Each instance only runs under the lock of its own transmit queue and
+ * keeps a private bucket filled at its current share of the group rate.
+ * A group timer periodically splits the group rate between the queues
+ * according to the traffic they saw during the last interval, every
+ * queue keeps a minimum share so that it can pick up traffic quickly.
+ * Unlike HTB, the enqueue and dequeue paths never touch state shared
+ * with the other queues, so shaping scales with the number of queues.
+ *
+ * The aggregate may briefly exceed the group rate by the sum of the
+ * queue bursts after a rebalance, which is the price for not
+ * synchronizing the buckets.
+ */
+
+#include <linux/module.h>
+#include <linux/types.h>
+#include <linux/kernel.h>
+#include <linux/errno.h>
+#include <linux/skbuff.h>
+#include <linux/timer.h>
+#include <net/netlink.h>
+#include <net/net_namespace.h>
+#include <net/sch_generic.h>
+#include <net/pkt_sched.h>
+
+#define MTB_REBALANCE_INTERVAL	msecs_to_jiffies(10)
+
+/* every member keeps at least 1/MTB_MIN_SHARE_DIV of its fair share */
+#define MTB_MIN_SHARE_DIV	4
+
+struct mtb_group {
+	struct list_head	list;
+	possible_net_t		net;
+	u32			id;
+	u32			users;
+
+	u64			rate;		/* bytes per second */
+
+	spinlock_t		lock;		/* protects members */
+	struct list_head	members;
+	u32			nr_members;
+	struct timer_list	timer;
+};
+
+struct mtb_sched_data {
+/* Parameters */
+	u32		limit;		/* Maximal length of backlog: packets */
+	u32		burst;		/* Bucket depth: bytes */
+	struct mtb_group *group;
+	struct list_head member;
+	struct Qdisc	*sch;
+
+/* Variables */
+	u64		share;		/* Current rate: bytes per second */
+	s64		tokens;		/* Current number of tokens: bytes */
+	u64		t_c;		/* Time check-point */
+	unsigned long	enqueued;	/* Bytes enqueued, read by rebalance */
+	unsigned long	last_enqueued;	/* Owned by rebalance */
+	struct qdisc_watchdog watchdog;	/* Watchdog timer */
+};
+
+static DEFINE_MUTEX(mtb_groups_lock);
+static LIST_HEAD(mtb_groups);
+
+static void mtb_rebalance(struct timer_list *t)
+{
+	struct mtb_group *group = from_timer(group, t, timer);
+	u64 rate = READ_ONCE(group->rate);
+	u64 floor, spare, total = 0;
+	struct mtb_sched_data *q;
+
+	spin_lock(&group->lock);
+	if (!group->nr_members)
+		goto out;
+
+	floor = div_u64(rate, group->nr_members * MTB_MIN_SHARE_DIV) ?: 1;
+	spare = rate > floor * group->nr_members ?
+		rate - floor * group->nr_members : 0;
+
+	list_for_each_entry(q, &group->members, member)
+		total += READ_ONCE(q->enqueued) - q->last_enqueued +
+			 READ_ONCE(q->sch->qstats.backlog);
+
+	list_for_each_entry(q, &group->members, member) {
+		unsigned long enqueued = READ_ONCE(q->enqueued);
+		u64 demand, share, weight;
+
+		demand = enqueued - q->last_enqueued +
+			 READ_ONCE(q->sch->qstats.backlog);
+		q->last_enqueued = enqueued;
+
+		/* weight in 1/1024 of the spare rate */
+		if (total)
+			weight = div64_u64(demand << 10, total);
+		else
+			weight = div_u64(1 << 10, group->nr_members);
+
+		share = floor + ((spare * weight) >> 10);
+
+		/* a throttled queue may sleep on a deadline computed with
+		 * its old share, kick it when it may send earlier.
+		 */
+		if (share > q->share && READ_ONCE(q->sch->q.qlen)) {
+			WRITE_ONCE(q->share, share);
+			rcu_read_lock();
+			__netif_schedule(qdisc_root(q->sch));
+			rcu_read_unlock();
+		} else {
+			WRITE_ONCE(q->share, share);
+		}
+	}
+
+	mod_timer(&group->timer, jiffies + MTB_REBALANCE_INTERVAL);
+out:
+	spin_unlock(&group->lock);
+}
+
+/* Called with mtb_groups_lock held. */
+static struct mtb_group *mtb_group_get(struct net *net, u32 id, u64 rate,
+				       struct netlink_ext_ack *extack)
+{
+	struct mtb_group *group;
+
+	list_for_each_entry(group, &mtb_groups, list) {
+		if (group->id == id && net_eq(read_pnet(&group->net), net)) {
+			group->users++;
+			return group;
+		}
+	}
+
+	if (!rate) {
+		NL_SET_ERR_MSG(extack, "A new group requires a rate");
+		return ERR_PTR(-EINVAL);
+	}
+
+	group = kzalloc(sizeof(*group), GFP_KERNEL);
+	if (!group)
+		return ERR_PTR(-ENOMEM);
+
+	write_pnet(&group->net, net);
+	group->id = id;
+	group->users = 1;
+	group->rate = rate;
+	spin_lock_init(&group->lock);
+	INIT_LIST_HEAD(&group->members);
+	timer_setup(&group->timer, mtb_rebalance, 0);
+	list_add(&group->list, &mtb_groups);
+
+	return group;
+}
+
+/* Called with mtb_groups_lock held. */
+static void mtb_group_join(struct mtb_sched_data *q, struct mtb_group *group)
+{
+	spin_lock_bh(&group->lock);
+	group->nr_members++;
+	WRITE_ONCE(q->share, div_u64(READ_ONCE(group->rate),
+				     group->nr_members) ?: 1);
+	list_add_tail(&q->member, &group->members);
+	if (group->nr_members == 1)
+		mod_timer(&group->timer, jiffies + MTB_REBALANCE_INTERVAL);
+	spin_unlock_bh(&group->lock);
+
+	q->group = group;
+}
+
+/* Called with mtb_groups_lock held. */
+static void mtb_group_leave(struct mtb_sched_data *q)
+{
+	struct mtb_group *group = q->group;
+
+	if (!group)
+		return;
+
+	spin_lock_bh(&group->lock);
+	list_del(&q->member);
+	group->nr_members--;
+	spin_unlock_bh(&group->lock);
+
+	q->group = NULL;
+
+	if (--group->users)
+		return;
+
+	list_del(&group->list);
+	del_timer_sync(&group->timer);
+	kfree(group);
+}
+
+static int mtb_enqueue(struct sk_buff *skb, struct Qdisc *sch,
+		       struct sk_buff **to_free)
+{
+	struct mtb_sched_data *q = qdisc_priv(sch);
+
+	if (unlikely(sch->q.qlen >= q->limit))
+		return qdisc_drop(skb, sch, to_free);
+
+	q->enqueued += qdisc_pkt_len(skb);
+
+	return qdisc_enqueue_tail(skb, sch);
+}
+
+static struct sk_buff *mtb_dequeue(struct Qdisc *sch)
+{
+	struct mtb_sched_data *q = qdisc_priv(sch);
+	u64 share = READ_ONCE(q->share);
+	struct sk_buff *skb;
+	u64 now, elapsed, deficit;
+	s64 toks, need;
+
+	skb = qdisc_peek_head(sch);
+	if (!skb)
+		return NULL;
+
+	now = ktime_get_ns();
+	elapsed = now - q->t_c;
+	deficit = q->burst - q->tokens;
+
+	/* Past the time needed to fill the bucket the result is known, and
+	 * below it elapsed * share stays under deficit * NSEC_PER_SEC, which
+	 * cannot overflow whatever the rate.
+	 */
+	if (elapsed >= div64_u64(deficit * NSEC_PER_SEC, share))
+		toks = q->burst;
+	else
+		toks = q->tokens + div64_u64(elapsed * share, NSEC_PER_SEC);
+	q->tokens = toks;
+	q->t_c = now;
+
+	/* GSO packets larger than the bucket are sent on credit */
+	need = min_t(s64, qdisc_pkt_len(skb), q->burst);
+	if (toks < need) {
+		qdisc_watchdog_schedule_ns(&q->watchdog,
+					   now + div64_u64((need - toks) *
+							   NSEC_PER_SEC,
+							   share));
+		qdisc_qstats_overlimit(sch);
+		return NULL;
+	}
+
+	skb = qdisc_dequeue_head(sch);
+	q->tokens -= qdisc_pkt_len(skb);
+	qdisc_bstats_update(sch, skb);
+
+	return skb;
+}
+
+static void mtb_reset(struct Qdisc *sch)
+{
+	struct mtb_sched_data *q = qdisc_priv(sch);
+
+	qdisc_reset_queue(sch);
+	q->t_c = ktime_get_ns();
+	q->tokens = q->burst;
+	qdisc_watchdog_cancel(&q->watchdog);
+}
+
+static const struct nla_policy mtb_policy[TCA_MTB_MAX + 1] = {
+	[TCA_MTB_GROUP]		= { .type = NLA_U32 },
+	[TCA_MTB_RATE64]	= { .type = NLA_U64 },
+	[TCA_MTB_BURST]		= { .type = NLA_U32 },
+	[TCA_MTB_LIMIT]		= { .type = NLA_U32 },
+};
+
+static int mtb_change(struct Qdisc *sch, struct nlattr *opt,
+		      struct netlink_ext_ack *extack)
+{
+	struct mtb_sched_data *q = qdisc_priv(sch);
+	struct nlattr *tb[TCA_MTB_MAX + 1];
+	unsigned int qlen, dropped = 0;
+	u64 rate = 0;
+	u32 id;
+	int err;
+
+	err = nla_parse_nested(tb, TCA_MTB_MAX, opt, mtb_policy, extack);
+	if (err < 0)
+		return err;
+
+	if (tb[TCA_MTB_RATE64])
+		rate = nla_get_u64(tb[TCA_MTB_RATE64]);
+
+	if (tb[TCA_MTB_GROUP])
+		id = nla_get_u32(tb[TCA_MTB_GROUP]);
+	else
+		id = q->group ? q->group->id : 0;
+
+	mutex_lock(&mtb_groups_lock);
+	if (!q->group || q->group->id != id) {
+		struct mtb_group *group;
+
+		group = mtb_group_get(dev_net(qdisc_dev(sch)), id, rate,
+				      extack);
+		if (IS_ERR(group)) {
+			mutex_unlock(&mtb_groups_lock);
+			return PTR_ERR(group);
+		}
+
+		mtb_group_leave(q);
+		mtb_group_join(q, group);
+	}
+	if (rate)
+		WRITE_ONCE(q->group->rate, rate);
+	mutex_unlock(&mtb_groups_lock);
+
+	sch_tree_lock(sch);
+
+	if (tb[TCA_MTB_LIMIT])
+		q->limit = nla_get_u32(tb[TCA_MTB_LIMIT]) ?: 1;
+	if (tb[TCA_MTB_BURST])
+		q->burst = max(nla_get_u32(tb[TCA_MTB_BURST]),
+			       psched_mtu(qdisc_dev(sch)));
+	q->tokens = min_t(s64, q->tokens, q->burst);
+
+	qlen = sch->q.qlen;
+	while (sch->q.qlen > q->limit) {
+		struct sk_buff *skb = __qdisc_dequeue_head(&sch->q);
+
+		dropped += qdisc_pkt_len(skb);
+		qdisc_qstats_backlog_dec(sch, skb);
+		rtnl_qdisc_drop(skb, sch);
+	}
+	qdisc_tree_reduce_backlog(sch, qlen - sch->q.qlen, dropped);
+
+	sch_tree_unlock(sch);
+
+	return 0;
+}
+
+static int mtb_init(struct Qdisc *sch, struct nlattr *opt,
+		    struct netlink_ext_ack *extack)
+{
+	struct mtb_sched_data *q = qdisc_priv(sch);
+	struct net_device *dev = qdisc_dev(sch);
+
+	q->sch = sch;
+	INIT_LIST_HEAD(&q->member);
+	qdisc_watchdog_init(&q->watchdog, sch);
+
+	if (!opt) {
+		NL_SET_ERR_MSG(extack, "Missing MTB qdisc options");
+		return -EINVAL;
+	}
+
+	q->limit = dev->tx_queue_len ?: 1;
+	q->burst = 10 * psched_mtu(dev);
+	q->tokens = q->burst;
+	q->t_c = ktime_get_ns();
+
+	return mtb_change(sch, opt, extack);
+}
+
+static void mtb_destroy(struct Qdisc *sch)
+{
+	struct mtb_sched_data *q = qdisc_priv(sch);
+
+	qdisc_watchdog_cancel(&q->watchdog);
+
+	mutex_lock(&mtb_groups_lock);
+	mtb_group_leave(q);
+	mutex_unlock(&mtb_groups_lock);
+}
+
+static int mtb_dump(struct Qdisc *sch, struct sk_buff *skb)
+{
+	struct mtb_sched_data *q = qdisc_priv(sch);
+	struct nlattr *opts;
+
+	opts = nla_nest_start(skb, TCA_OPTIONS);
+	if (!opts)
+		goto nla_put_failure;
+
+	if (nla_put_u32(skb, TCA_MTB_GROUP, q->group->id) ||
+	    nla_put_u64_64bit(skb, TCA_MTB_RATE64, READ_ONCE(q->group->rate),
+			      TCA_MTB_PAD) ||
+	    nla_put_u32(skb, TCA_MTB_BURST, q->burst) ||
+	    nla_put_u32(skb, TCA_MTB_LIMIT, q->limit))
+		goto nla_put_failure;
+
+	return nla_nest_end(skb, opts);
+
+nla_put_failure:
+	nla_nest_cancel(skb, opts);
+	return -1;
+}
+
+static int mtb_dump_stats(struct Qdisc *sch, struct gnet_dump *d)
+{
+	struct mtb_sched_data *q = qdisc_priv(sch);
+	struct tc_mtb_xstats st = {
+		.share		= READ_ONCE(q->share),
+		.members	= READ_ONCE(q->group->nr_members),
+	};
+
+	return gnet_stats_copy_app(d, &st, sizeof(st));
+}
+
+static struct Qdisc_ops mtb_qdisc_ops __read_mostly = {
+	.id		=	"mtb",
+	.priv_size	=	sizeof(struct mtb_sched_data),
+	.enqueue	=	mtb_enqueue,
+	.dequeue	=	mtb_dequeue,
+	.peek		=	qdisc_peek_dequeued,
+	.init		=	mtb_init,
+	.reset		=	mtb_reset,
+	.destroy	=	mtb_destroy,
+	.change		=	mtb_change,
+	.dump		=	mtb_dump,
+	.dump_stats	=	mtb_dump_stats,
+	.owner		=	THIS_MODULE,
+};
+
+static int __init mtb_module_init(void)
+{
+	return register_qdisc(&mtb_qdisc_ops);
+}
+
+static void __exit mtb_module_exit(void)
+{
+	unregister_qdisc(&mtb_qdisc_ops);
+}
+
+module_init(mtb_module_init)
+module_exit(mtb_module_exit)
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Multiqueue token bucket shaper");
@@ -1181,8 +1181,7 @@ static int cfg80211_netdev_notifier_call(struct notifier_block *nb,
 		mutex_init(&wdev->mtx);
 		INIT_LIST_HEAD(&wdev->event_list);
 		spin_lock_init(&wdev->event_lock);
-		INIT_LIST_HEAD(&wdev->mgmt_registrations);
-		spin_lock_init(&wdev->mgmt_registrations_lock);
+		cfg80211_mlme_init_registrations(wdev);
 
 		/*
 		 * We get here also when the interface changes network namespaces,
@@ -413,6 +413,7 @@ void cfg80211_mlme_down(struct cfg80211_registered_device *rdev,
 
 struct cfg80211_mgmt_registration {
 	struct list_head list;
+	struct hlist_node stype_list;
 	struct wireless_dev *wdev;
 
 	u32 nlportid;
@@ -516,6 +517,8 @@ int cfg80211_mlme_register_mgmt(struct wireless_dev *wdev, u32 snd_portid,
 	nreg->frame_type = cpu_to_le16(frame_type);
 	nreg->wdev = wdev;
 	list_add(&nreg->list, &wdev->mgmt_registrations);
+	hlist_add_head(&nreg->stype_list,
+		       &wdev->mgmt_registrations_stype[mgmt_type]);
 	spin_unlock_bh(&wdev->mgmt_registrations_lock);
 
 	/* process all unregistrations to avoid driver confusion */
@@ -544,6 +547,7 @@ void cfg80211_mlme_unregister_socket(struct wireless_dev *wdev, u32 nlportid)
 		if (reg->nlportid != nlportid)
 			continue;
 
+		hlist_del(&reg->stype_list);
 		list_del(&reg->list);
 		spin_lock(&rdev->mlme_unreg_lock);
 		list_add_tail(&reg->list, &rdev->mlme_unreg);
@@ -566,16 +570,29 @@ void cfg80211_mlme_unregister_socket(struct wireless_dev *wdev, u32 nlportid)
 void cfg80211_mlme_purge_registrations(struct wireless_dev *wdev)
 {
 	struct cfg80211_registered_device *rdev = wiphy_to_rdev(wdev->wiphy);
+	int i;
 
 	spin_lock_bh(&wdev->mgmt_registrations_lock);
 	spin_lock(&rdev->mlme_unreg_lock);
 	list_splice_tail_init(&wdev->mgmt_registrations, &rdev->mlme_unreg);
 	spin_unlock(&rdev->mlme_unreg_lock);
+	for (i = 0; i < ARRAY_SIZE(wdev->mgmt_registrations_stype); i++)
+		INIT_HLIST_HEAD(&wdev->mgmt_registrations_stype[i]);
 	spin_unlock_bh(&wdev->mgmt_registrations_lock);
 
 	cfg80211_process_mlme_unregistrations(rdev);
 }
 
+void cfg80211_mlme_init_registrations(struct wireless_dev *wdev)
+{
+	int i;
+
+	INIT_LIST_HEAD(&wdev->mgmt_registrations);
+	for (i = 0; i < ARRAY_SIZE(wdev->mgmt_registrations_stype); i++)
+		INIT_HLIST_HEAD(&wdev->mgmt_registrations_stype[i]);
+	spin_lock_init(&wdev->mgmt_registrations_lock);
+}
+
 int cfg80211_mlme_mgmt_tx(struct cfg80211_registered_device *rdev,
 			  struct wireless_dev *wdev,
 			  struct cfg80211_mgmt_tx_params *params, u64 *cookie)
@@ -721,7 +738,8 @@ bool cfg80211_rx_mgmt(struct wireless_dev *wdev, int freq, int sig_dbm,
 
 	spin_lock_bh(&wdev->mgmt_registrations_lock);
 
-	list_for_each_entry(reg, &wdev->mgmt_registrations, list) {
+	hlist_for_each_entry(reg, &wdev->mgmt_registrations_stype[stype],
+			     stype_list) {
 		if (reg->frame_type != ftype)
 			continue;
 
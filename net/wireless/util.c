@@ -542,6 +542,9 @@ __frame_add_frag(struct sk_buff *skb, struct page *page,
 	skb_add_rx_frag(skb, sh->nr_frags, page, page_offset, len, size);
 }
 
+/* subframe bytes copied to the head when the payload is shared */
+#define AMSDU_COPY_HEAD_LEN	32
+
 static void
 __ieee80211_amsdu_copy_frag(struct sk_buff *skb, struct sk_buff *frame,
 			    int offset, int len)
@@ -600,7 +603,7 @@ __ieee80211_amsdu_copy(struct sk_buff *skb, unsigned int hlen,
 	 * in the stack later.
 	 */
 	if (reuse_frag)
-		cur_len = min_t(int, len, 32);
+		cur_len = min_t(int, len, AMSDU_COPY_HEAD_LEN);
 
 	/*
 	 * Allocate and reserve two bytes more for payload
@@ -635,11 +638,14 @@ void ieee80211_amsdu_to_8023s(struct sk_buff *skb, struct sk_buff_head *list,
 	int offset = 0, remaining;
 	struct ethhdr eth;
 	bool reuse_frag = skb->head_frag && !skb_has_frag_list(skb);
+	bool paged = !skb->head_frag && skb_is_nonlinear(skb) &&
+		     !skb_has_frag_list(skb);
 	bool reuse_skb = false;
 	bool last = false;
 
 	while (!last) {
 		unsigned int subframe_len;
+		bool frag;
 		int len;
 		u8 padding;
 
@@ -670,8 +676,16 @@ void ieee80211_amsdu_to_8023s(struct sk_buff *skb, struct sk_buff_head *list,
 			frame = skb;
 			reuse_skb = true;
 		} else {
+			/*
+			 * Without a page backed head the page fragments can
+			 * still be shared by subframes that lie in them.
+			 */
+			frag = reuse_frag ||
+			       (paged && offset + AMSDU_COPY_HEAD_LEN >=
+					 skb_headlen(skb));
+
 			frame = __ieee80211_amsdu_copy(skb, hlen, offset, len,
-						       reuse_frag);
+						       frag);
 			if (!frame)
 				goto purge;
 